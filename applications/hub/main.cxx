@@ -35,6 +35,7 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <memory>
@@ -42,6 +43,7 @@
 #include "executor/Executor.hxx"
 #include "executor/Service.hxx"
 #include "os/os.h"
+#include "utils/CanHubShards.hxx"
 #include "utils/ClientConnection.hxx"
 #include "utils/GcTcpHub.hxx"
 #include "utils/Hub.hxx"
@@ -74,6 +76,9 @@ bool timestamped = false;
 bool export_mdns = false;
 const char* mdns_name = "openmrn_hub";
 bool printpackets = false;
+unsigned num_workers = 0;
+/// Largest value accepted for -w.
+static constexpr long MAX_WORKERS = 64;
 
 void usage(const char *e)
 {
@@ -83,7 +88,7 @@ void usage(const char *e)
 #if defined(__linux__)
         "[-s socketcan_interface] "
 #endif
-        "[-t] [-l]\n\n",
+        "[-t] [-l] [-w num_workers]\n\n",
         e);
     fprintf(stderr,
         "GridConnect CAN HUB.\nListens to a specific TCP port, "
@@ -108,6 +113,10 @@ void usage(const char *e)
             "\t-t prints timestamps for each packet.\n");
     fprintf(stderr,
             "\t-l print all packets.\n");
+    fprintf(stderr,
+            "\t-w num_workers   distributes the TCP clients among this many "
+            "worker threads (1 to %ld). If not specified, all clients run on "
+            "the main thread.\n", MAX_WORKERS);
 #ifdef HAVE_AVAHI_CLIENT
     fprintf(stderr,
             "\t-m exports the current service on mDNS.\n");
@@ -120,7 +129,7 @@ void usage(const char *e)
 void parse_args(int argc, char *argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "hp:d:s:u:q:tlmn:")) >= 0)
+    while ((opt = getopt(argc, argv, "hp:d:s:u:q:tlmn:w:")) >= 0)
     {
         switch (opt)
         {
@@ -157,6 +166,18 @@ void parse_args(int argc, char *argv[])
             case 'l':
                 printpackets = true;
                 break;
+            case 'w':
+            {
+                char *end;
+                long n = strtol(optarg, &end, 10);
+                if (end == optarg || *end || n < 1 || n > MAX_WORKERS)
+                {
+                    fprintf(stderr, "Invalid number of workers: %s\n", optarg);
+                    usage(argv[0]);
+                }
+                num_workers = n;
+                break;
+            }
             default:
                 fprintf(stderr, "Unknown option %c\n", opt);
                 usage(argv[0]);
@@ -178,7 +199,17 @@ int appl_main(int argc, char *argv[])
         packet_printer = new GcPacketPrinter(&can_hub0, timestamped);
     }
     fprintf(stderr,"packet_printer points to %p\n",packet_printer);
-    GcTcpHub hub(&can_hub0, port);
+    std::unique_ptr<CanHubShards> shards;
+    std::unique_ptr<GcTcpHub> hub;
+    if (num_workers > 0)
+    {
+        shards.reset(new CanHubShards(&can_hub0, num_workers));
+        hub.reset(new GcTcpHub(shards.get(), port));
+    }
+    else
+    {
+        hub.reset(new GcTcpHub(&can_hub0, port));
+    }
     vector<std::unique_ptr<ConnectionClient>> connections;
 
 #ifdef HAVE_AVAHI_CLIENT
@@ -78,6 +78,16 @@ DECLARE_CONST(executor_select_prescaler);
  */
 DECLARE_CONST(executor_max_sleep_msec);
 
+/** Set to CONSTANT_TRUE to have executors wait for file descriptors using
+ * epoll instead of select, where available (Linux). */
+DECLARE_CONST(executor_use_epoll);
+
+/** Number of free buffers each thread moves at a time between its own
+ * magazines and the shared buckets of mainBufferPool. 0 disables the
+ * per-thread magazines. Only used where OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+ * is set. */
+DECLARE_CONST(buffer_pool_magazine_size);
+
 /** Number of packets to queue in the CANbus device driver for send. Each packet
  * takes 16 bytes of RAM. */
 DECLARE_CONST(can_tx_buffer_size);
@@ -134,8 +144,9 @@ DECLARE_CONST(remote_alias_cache_size);
 /** Number of entries in the local alias cache */
 DECLARE_CONST(local_alias_cache_size);
 
-/** Keep this many allocated but unused aliases around. (Currently supported
- * values are 0 or 1.) */
+/** Keep this many allocated but unused aliases around. With values above 1
+ * the aliases are reserved in bulk in the background; the local alias cache
+ * needs to be correspondingly larger. */
 DECLARE_CONST(reserve_unused_alias_count);
 
 /** Maximum number of local nodes */
@@ -166,6 +177,18 @@ DECLARE_CONST(enable_all_memory_space);
  * standard. */
 DECLARE_CONST(node_init_identify);
 
+/** Set to CONSTANT_TRUE to use the flat sorted-array event registry
+ * (FlatEventHandlers) instead of the tree. */
+DECLARE_CONST(flat_event_registry);
+
+/** Set to CONSTANT_TRUE to use hash tables for the lookups in the remote
+ * alias cache. */
+DECLARE_CONST(remote_alias_cache_hash_index);
+
+/** Set to CONSTANT_TRUE to look up the destination of incoming addressed
+ * messages in an alias-indexed table of the local nodes. */
+DECLARE_CONST(local_node_alias_index);
+
 /** How many CAN frames should the bulk alias allocator be sending at the same
  * time. */
 DECLARE_CONST(bulk_alias_num_can_frames);
@@ -174,6 +197,19 @@ DECLARE_CONST(bulk_alias_num_can_frames);
  * StreamReceiver }. */
 DECLARE_CONST(stream_receiver_default_window_size);
 
+/** Milliseconds without incoming data after which a memory config write
+ * stream is rejected and its stream receiver released. */
+DECLARE_CONST(stream_write_timeout_msec);
+
+/** Milliseconds per kilobyte of payload that a memory config client waits,
+ * after sending a write stream, for the remote node to write the data and
+ * send the Write Stream Reply. This is on top of a fixed 3 seconds. */
+DECLARE_CONST(stream_write_reply_msec_per_kb);
+
+/** Set to CONSTANT_TRUE to keep a write-back copy of the config file in RAM
+ * (see @ref openlcb::ConfigCache). */
+DECLARE_CONST(cache_config_file);
+
 /** Stack size for @ref SocketListener threads. */
 DECLARE_CONST(socket_listener_stack_size);
 
@@ -86,6 +86,40 @@
 #define OPENMRN_HAVE_SELECT 1
 #endif
 
+#if defined(__linux__) && defined(OPENMRN_HAVE_PSELECT)
+/// Uses ::epoll_pwait in the Executor instead of pselect. The signal based
+/// wakeup is shared with pselect. Can be turned off at link time with the
+/// executor_use_epoll constant.
+#define OPENMRN_HAVE_EPOLL 1
+#endif
+
+#if defined(__linux__) || defined(__MACH__)
+/// Uses ::writev to send multiple buffers with one system call.
+#define OPENMRN_HAVE_WRITEV 1
+#endif
+
+#if defined(__linux__) || defined(__MACH__)
+/// DynamicPool can keep per-thread magazines of free buffers (needs
+/// thread_local support from the compiler and the C library).
+#define OPENMRN_FEATURE_BUFFER_THREAD_CACHE 1
+#endif
+
+#if defined(__linux__) || defined(__MACH__)
+/// The executor queues items in lock-free lists (QListMpsc) instead of a
+/// mutex protected QList.
+#define OPENMRN_FEATURE_LOCKFREE_QUEUE 1
+/// Compiles ExecutorPool, which runs many executors (strands) on a group of
+/// worker threads.
+#define OPENMRN_FEATURE_EXECUTOR_POOL 1
+#endif
+
+#if (defined(__linux__) || defined(__MACH__)) && defined(__GXX_RTTI)
+/// Compiles the ExecutorProfiler and the hooks in the executor loop that feed
+/// it. Run-time statistics are collected per Executable type, thus RTTI is
+/// needed.
+#define OPENMRN_FEATURE_EXECUTOR_PROFILING 1
+#endif
+
 #if defined(OPENMRN_HAVE_SELECT) || defined(OPENMRN_HAVE_PSELECT) ||           \
     defined(OPENMRN_FEATURE_DEVICE_SELECT)
 #define OPENMRN_FEATURE_EXECUTOR_SELECT 1
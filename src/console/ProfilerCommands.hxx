@@ -0,0 +1,142 @@
+/** @copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file ProfilerCommands.hxx
+ * Console commands for the executor profiler.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#ifndef _CONSOLE_PROFILERCOMMANDS_HXX_
+#define _CONSOLE_PROFILERCOMMANDS_HXX_
+
+#include "console/Console.hxx"
+#include "executor/ExecutorProfiler.hxx"
+
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+
+/// Adds the "profile" command to a console, which controls an
+/// ExecutorProfiler on a given executor and prints its statistics.
+///
+/// The console should run on a different executor than the one being
+/// profiled, otherwise the statistics cannot be read while that executor is
+/// stuck.
+class ProfilerCommands
+{
+public:
+    /// Constructor.
+    /// @param console console instance to add the commands to
+    /// @param executor the executor to profile
+    /// @param start_enabled true to start profiling right away
+    ProfilerCommands(
+        Console *console, ExecutorBase *executor, bool start_enabled = false)
+        : executor_(executor)
+    {
+        console->add_command("profile", profile_command, this);
+        if (start_enabled)
+        {
+            executor_->set_profiler(&profiler_);
+        }
+    }
+
+    /// Destructor. Turns off the profiling if it is still on.
+    ~ProfilerCommands()
+    {
+        if (executor_->profiler() == &profiler_)
+        {
+            executor_->set_profiler(nullptr);
+        }
+    }
+
+    /// @return the profiler that the commands control.
+    ExecutorProfiler *profiler()
+    {
+        return &profiler_;
+    }
+
+private:
+    /// Controls profiling and prints the statistics.
+    /// @param fp file pointer to console
+    /// @param argc number of arguments including the command itself
+    /// @param argv array of arguments starting with the command itself
+    /// @param context pointer to the ProfilerCommands instance
+    /// @return COMMAND_OK on success, COMMAND_ERROR on bad arguments
+    static Console::CommandStatus profile_command(
+        FILE *fp, int argc, const char *argv[], void *context)
+    {
+        if (argc == 0)
+        {
+            fprintf(fp, "[on|off|reset] controls the executor profiler,\n%s"
+                        "without argument prints the statistics\n",
+                argv[1]);
+            return Console::COMMAND_OK;
+        }
+        // The help command passes no context.
+        ProfilerCommands *self = static_cast<ProfilerCommands *>(context);
+        if (argc == 1)
+        {
+            if (self->executor_->profiler() != &self->profiler_)
+            {
+                fprintf(fp, "profiler is off\n");
+            }
+            self->profiler_.dump(fp);
+            return Console::COMMAND_OK;
+        }
+        if (argc != 2)
+        {
+            return Console::COMMAND_ERROR;
+        }
+        if (!strcmp(argv[1], "on"))
+        {
+            self->executor_->set_profiler(&self->profiler_);
+        }
+        else if (!strcmp(argv[1], "off"))
+        {
+            self->executor_->set_profiler(nullptr);
+        }
+        else if (!strcmp(argv[1], "reset"))
+        {
+            self->profiler_.reset();
+        }
+        else
+        {
+            return Console::COMMAND_ERROR;
+        }
+        return Console::COMMAND_OK;
+    }
+
+    /// Executor being profiled.
+    ExecutorBase *executor_;
+    /// Where the statistics are collected.
+    ExecutorProfiler profiler_;
+
+    DISALLOW_COPY_AND_ASSIGN(ProfilerCommands);
+};
+
+#endif // OPENMRN_FEATURE_EXECUTOR_PROFILING
+
+#endif // _CONSOLE_PROFILERCOMMANDS_HXX_
@@ -34,17 +34,40 @@
  */
 
 #include "dcc/SimpleUpdateLoop.hxx"
+
+#include <algorithm>
+
 #include "dcc/Packet.hxx"
 #include "dcc/PacketSource.hxx"
 
 namespace dcc
 {
 
+/// Pass increment for a weight of one in the stride scheduling.
+static constexpr uint32_t STRIDE = 1 << 16;
+
+/// @return true if pass value a is before b (wraparound-safe).
+/// @param a pass value
+/// @param b pass value
+static inline bool pass_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+constexpr unsigned SimpleUpdateLoop::URGENT_QUEUE_SIZE;
+constexpr unsigned SimpleUpdateLoop::MAX_URGENT_IN_A_ROW;
+constexpr long long SimpleUpdateLoop::IDLE_TIMEOUT_NSEC;
+constexpr unsigned SimpleUpdateLoop::IDLE_REFRESH_DIVIDER;
+constexpr long long SimpleUpdateLoop::MIN_REPEAT_NSEC;
+
 SimpleUpdateLoop::SimpleUpdateLoop(Service *service, TrackIf *track_send)
     : StateFlow(service)
     , trackSend_(track_send)
-    , nextRefreshIndex_(0)
-    , lastCycleStart_(os_get_time_monotonic())
+    , urgentHead_(0)
+    , urgentCount_(0)
+    , urgentInARow_(0)
+    , lastSource_(nullptr)
+    , lastSendTime_(0)
 {
 }
 
@@ -52,31 +75,270 @@ SimpleUpdateLoop::~SimpleUpdateLoop()
 {
 }
 
+bool SimpleUpdateLoop::add_refresh_source(
+    dcc::PacketSource *source, unsigned priority)
+{
+    long long now = os_get_time_monotonic();
+    AtomicHolder h(this);
+    auto it = classes_.begin();
+    while (it != classes_.end() && it->priority > priority)
+    {
+        ++it;
+    }
+    if (it == classes_.end() || it->priority != priority)
+    {
+        PriorityClass c;
+        c.priority = priority;
+        // Starts at the front of the schedule, so that the new class does
+        // not get a burst of slots to catch up.
+        c.pass = 0;
+        for (unsigned i = 0; i < classes_.size(); ++i)
+        {
+            if (i == 0 || pass_before(classes_[i].pass, c.pass))
+            {
+                c.pass = classes_[i].pass;
+            }
+        }
+        c.nextIndex = 0;
+        c.round = 0;
+        it = classes_.insert(it, std::move(c));
+    }
+    it->entries.push_back({source, now});
+    return classes_.front().priority < EXCLUSIVE_MIN_PRIORITY ||
+        classes_.front().priority <= priority;
+}
+
+void SimpleUpdateLoop::remove_refresh_source(dcc::PacketSource *source)
+{
+    AtomicHolder h(this);
+    for (auto it = classes_.begin(); it != classes_.end();)
+    {
+        auto &entries = it->entries;
+        for (size_t i = 0; i < entries.size();)
+        {
+            if (entries[i].source == source)
+            {
+                entries.erase(entries.begin() + i);
+                if (it->nextIndex > i)
+                {
+                    --it->nextIndex;
+                }
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        if (entries.empty())
+        {
+            it = classes_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    // Drops the pending urgent updates, keeping the order of the rest.
+    unsigned count = 0;
+    for (unsigned i = 0; i < urgentCount_; ++i)
+    {
+        const UrgentUpdate &u = urgent_[(urgentHead_ + i) % URGENT_QUEUE_SIZE];
+        if (u.source != source)
+        {
+            urgent_[(urgentHead_ + count) % URGENT_QUEUE_SIZE] = u;
+            ++count;
+        }
+    }
+    urgentCount_ = count;
+    if (lastSource_ == source)
+    {
+        lastSource_ = nullptr;
+    }
+}
+
+void SimpleUpdateLoop::notify_update(PacketSource *source, unsigned code)
+{
+    long long now = os_get_time_monotonic();
+    AtomicHolder h(this);
+    for (auto &c : classes_)
+    {
+        for (auto &e : c.entries)
+        {
+            if (e.source == source)
+            {
+                e.lastUpdate = now;
+            }
+        }
+    }
+    for (unsigned i = 0; i < urgentCount_; ++i)
+    {
+        const UrgentUpdate &u = urgent_[(urgentHead_ + i) % URGENT_QUEUE_SIZE];
+        if (u.source == source && u.code == code)
+        {
+            // Already pending. The source will generate the packet from its
+            // latest state.
+            return;
+        }
+    }
+    if (urgentCount_ >= URGENT_QUEUE_SIZE)
+    {
+        // Queue full. The background refresh will get to this source.
+        return;
+    }
+    urgent_[(urgentHead_ + urgentCount_) % URGENT_QUEUE_SIZE] = {source, code};
+    ++urgentCount_;
+}
+
+bool SimpleUpdateLoop::allowed(PacketSource *source)
+{
+    if (classes_.empty() || classes_.front().priority < EXCLUSIVE_MIN_PRIORITY)
+    {
+        return true;
+    }
+    for (const auto &e : classes_.front().entries)
+    {
+        if (e.source == source)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+PacketSource *SimpleUpdateLoop::take_urgent(long long now, unsigned *code)
+{
+    for (unsigned i = 0; i < urgentCount_; ++i)
+    {
+        UrgentUpdate &u = urgent_[(urgentHead_ + i) % URGENT_QUEUE_SIZE];
+        if (!can_send_to(u.source, now) || !allowed(u.source))
+        {
+            continue;
+        }
+        PacketSource *ret = u.source;
+        *code = u.code;
+        // Removes entry i by moving the earlier ones up by one.
+        for (unsigned j = i; j > 0; --j)
+        {
+            urgent_[(urgentHead_ + j) % URGENT_QUEUE_SIZE] =
+                urgent_[(urgentHead_ + j - 1) % URGENT_QUEUE_SIZE];
+        }
+        urgentHead_ = (urgentHead_ + 1) % URGENT_QUEUE_SIZE;
+        --urgentCount_;
+        return ret;
+    }
+    return nullptr;
+}
+
+bool SimpleUpdateLoop::find_refresh(
+    const PriorityClass &c, long long now, size_t *index, unsigned *round)
+{
+    size_t num = c.entries.size();
+    size_t idx = c.nextIndex;
+    unsigned r = c.round;
+    // Within IDLE_REFRESH_DIVIDER rounds every source comes up once.
+    for (size_t steps = 0; steps < num * IDLE_REFRESH_DIVIDER; ++steps)
+    {
+        if (idx >= num)
+        {
+            idx = 0;
+            ++r;
+        }
+        const RefreshEntry &e = c.entries[idx];
+        if (can_send_to(e.source, now))
+        {
+            bool idle = now - e.lastUpdate > IDLE_TIMEOUT_NSEC &&
+                e.source->get_speed().speed() == 0;
+            if (!idle || (r + idx) % IDLE_REFRESH_DIVIDER == 0)
+            {
+                *index = idx;
+                *round = r;
+                return true;
+            }
+        }
+        ++idx;
+    }
+    return false;
+}
+
+PacketSource *SimpleUpdateLoop::take_refresh(long long now)
+{
+    size_t num_classes = classes_.size();
+    if (num_classes && classes_.front().priority >= EXCLUSIVE_MIN_PRIORITY)
+    {
+        // Only the highest exclusive source gets packets.
+        num_classes = 1;
+    }
+    PriorityClass *best = nullptr;
+    size_t best_index = 0;
+    unsigned best_round = 0;
+    for (size_t i = 0; i < num_classes; ++i)
+    {
+        PriorityClass &c = classes_[i];
+        if (best && !pass_before(c.pass, best->pass))
+        {
+            continue;
+        }
+        size_t index;
+        unsigned round;
+        if (find_refresh(c, now, &index, &round))
+        {
+            best = &c;
+            best_index = index;
+            best_round = round;
+        }
+    }
+    if (!best)
+    {
+        return nullptr;
+    }
+    best->pass += STRIDE / (1 + std::min(best->priority, 0xFFu));
+    best->nextIndex = best_index + 1;
+    best->round = best_round;
+    return best->entries[best_index].source;
+}
+
 StateFlowBase::Action SimpleUpdateLoop::entry()
 {
-    long long current_time = os_get_time_monotonic();
-    long long prev_cycle_start = lastCycleStart_;
-    if (nextRefreshIndex_ >= refreshSources_.size())
+    long long now = os_get_time_monotonic();
+    PacketSource *source = nullptr;
+    unsigned code = 0;
+    {
+        AtomicHolder h(this);
+        if (urgentInARow_ < MAX_URGENT_IN_A_ROW)
+        {
+            source = take_urgent(now, &code);
+        }
+        if (source)
+        {
+            ++urgentInARow_;
+        }
+        else
+        {
+            urgentInARow_ = 0;
+            source = take_refresh(now);
+            if (!source)
+            {
+                source = take_urgent(now, &code);
+                urgentInARow_ = source ? 1 : 0;
+            }
+        }
+        if (source)
+        {
+            lastSource_ = source;
+            lastSendTime_ = now;
+        }
+    }
+    if (source)
     {
-        nextRefreshIndex_ = 0;
-        lastCycleStart_ = current_time;
+        source->get_next_packet(code, message()->data());
     }
-    if (nextRefreshIndex_ == 0 &&
-        (current_time - prev_cycle_start < MSEC_TO_NSEC(5) ||
-         refreshSources_.empty()))
+    else
     {
         // We do not want to send another packet to the same locomotive too
         // quick. We send an idle packet instead. OR: We do not have any
         // locomotives at all. We will keep sending idle packets.
         message()->data()->set_dcc_idle();
     }
-    else
-    {
-        // Send an update to the current loco.
-        refreshSources_[nextRefreshIndex_]
-            ->get_next_packet(0, message()->data());
-        nextRefreshIndex_++;
-    }
     // We pass on the filled packet to the track processor.
     trackSend_->send(transfer_message());
     return exit();
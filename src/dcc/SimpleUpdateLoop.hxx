@@ -36,7 +36,7 @@
 #ifndef _DCC_SIMPLEUPDATELOOP_HXX_
 #define _DCC_SIMPLEUPDATELOOP_HXX_
 
-#include <algorithm>
+#include <vector>
 
 #include "dcc/UpdateLoop.hxx"
 #include "executor/StateFlow.hxx"
@@ -44,9 +44,25 @@
 namespace dcc
 {
 
-/// Implementation of a command station update loop. This loop iterates over
-/// all locomotive implementations and polls them for the next packet in a
-/// strict round-robin behavior (no prioritization).
+/// Implementation of a command station update loop. This loop polls the
+/// packet sources for the next packet to send to the track.
+///
+/// - Update notifications (notify_update) are put into an urgent queue, which
+///   is served before the background refresh. A run of urgent packets is
+///   interrupted by a refresh packet every now and then, so the background
+///   refresh does not starve.
+///
+/// - The refresh sources are grouped into priority classes. The refresh
+///   slots are shared between the classes in proportion to (priority + 1),
+///   using stride scheduling; within a class the sources are refreshed
+///   round-robin. If there is a source with priority of at least
+///   EXCLUSIVE_MIN_PRIORITY, then only the highest such class gets packets.
+///
+/// - Sources that are stopped and have not been updated for a while are
+///   refreshed only every IDLE_REFRESH_DIVIDER-th time their turn comes up.
+///
+/// - No packets are sent to the same source within 5 msec; an idle packet is
+///   sent instead if there is nothing else to send.
 ///
 /// Usage:
 ///
@@ -65,44 +81,127 @@ public:
     SimpleUpdateLoop(Service *service, TrackIf *track_send);
     ~SimpleUpdateLoop();
 
-    /** Adds a new refresh source to the background refresh packets. */
+    /** Adds a new refresh source to the background refresh packets.
+     * @param source the packet source to add.
+     * @param priority defines the share of refresh slots for this source.
+     * @return false if there is a higher priority exclusive source. */
     bool add_refresh_source(
-        dcc::PacketSource *source, unsigned priority) OVERRIDE
+        dcc::PacketSource *source, unsigned priority) OVERRIDE;
+
+    /** Deletes a packet refresh source. Also drops any pending urgent
+     * updates for it. @param source the packet source to remove. */
+    void remove_refresh_source(dcc::PacketSource *source) OVERRIDE;
+
+    /** Queues an urgent update for a packet source.
+     * @param source the packet source that has a change.
+     * @param code will be passed to the source's get_next_packet. */
+    void notify_update(PacketSource *source, unsigned code) OVERRIDE;
+
+    // Entry to the state flow -- when a new packet needs to be sent.
+    Action entry() OVERRIDE;
+
+    /// Number of pending urgent updates that can be stored. Further updates
+    /// are dropped; the background refresh will deliver them later.
+    static constexpr unsigned URGENT_QUEUE_SIZE = 32;
+    /// After this many urgent packets in a row, a refresh packet is sent.
+    static constexpr unsigned MAX_URGENT_IN_A_ROW = 4;
+    /// A stopped source that was not updated for this long is idle.
+    static constexpr long long IDLE_TIMEOUT_NSEC = SEC_TO_NSEC(10);
+    /// Idle sources get only one of this many refresh turns.
+    static constexpr unsigned IDLE_REFRESH_DIVIDER = 4;
+    /// Minimum time between two packets to the same source.
+    static constexpr long long MIN_REPEAT_NSEC = MSEC_TO_NSEC(5);
+
+private:
+    /// Refresh state of a single packet source.
+    struct RefreshEntry
     {
-        /// @todo implement priority refresh.
-        AtomicHolder h(this);
-        refreshSources_.push_back(source);
-        return true;
-    }
+        /// The packet source.
+        PacketSource *source;
+        /// When the source was last added or updated.
+        long long lastUpdate;
+    };
 
-    /** Deletes a packet refresh source. */
-    void remove_refresh_source(dcc::PacketSource *source) OVERRIDE
+    /// Packet sources with the same priority.
+    struct PriorityClass
     {
-        AtomicHolder h(this);
-        refreshSources_.erase(
-            remove(refreshSources_.begin(), refreshSources_.end(), source),
-            refreshSources_.end());
-    }
+        /// Priority of all sources in this class.
+        unsigned priority;
+        /// Stride scheduling pass value. The class with the smallest pass
+        /// gets the next refresh slot.
+        uint32_t pass;
+        /// Offset in entries for the next source to refresh.
+        size_t nextIndex;
+        /// Counts how many times nextIndex wrapped around. Idle sources are
+        /// refreshed in every IDLE_REFRESH_DIVIDER-th round.
+        unsigned round;
+        /// Packet sources in this class.
+        std::vector<RefreshEntry> entries;
+    };
+
+    /// A pending urgent update.
+    struct UrgentUpdate
+    {
+        /// Which source to ask for a packet.
+        PacketSource *source;
+        /// Code to pass to the packet source.
+        unsigned code;
+    };
 
-    /** We ignore notifications. The loop will get to them anyway. */
-    void notify_update(PacketSource *source, unsigned code) OVERRIDE
+    /// @return true if an update for a source can be sent now.
+    /// @param source the packet source to check.
+    /// @param now current time.
+    bool can_send_to(PacketSource *source, long long now)
     {
+        return source != lastSource_ || now - lastSendTime_ >= MIN_REPEAT_NSEC;
     }
 
-    // Entry to the state flow -- when a new packet needs to be sent.
-    Action entry() OVERRIDE;
+    /// @return true if a source may get packets now, considering exclusive
+    /// sources. @param source the packet source to check.
+    bool allowed(PacketSource *source);
 
-private:
-    // Place where we forward the packets filled in.
+    /// Takes the next sendable urgent update from the queue. Must be called
+    /// with the lock held.
+    /// @param now current time.
+    /// @param code will be filled with the update code.
+    /// @return the source to ask for a packet, or nullptr.
+    PacketSource *take_urgent(long long now, unsigned *code);
+
+    /// Finds the next source in a class that should get a refresh packet.
+    /// Must be called with the lock held.
+    /// @param c the priority class to look at.
+    /// @param now current time.
+    /// @param index will be set to the offset of the source in c.entries.
+    /// @param round will be set to the round number of that source.
+    /// @return true if a source was found.
+    bool find_refresh(const PriorityClass &c, long long now, size_t *index,
+        unsigned *round);
+
+    /// Selects the next source for background refresh. Must be called with
+    /// the lock held.
+    /// @param now current time.
+    /// @return the source to ask for a packet, or nullptr.
+    PacketSource *take_refresh(long long now);
+
+    /// Place where we forward the packets filled in.
     TrackIf *trackSend_;
 
-    // Packet sources to ask about refreshing data periodically.
-    vector<dcc::PacketSource *> refreshSources_;
+    /// Priority classes, sorted by descending priority.
+    std::vector<PriorityClass> classes_;
+
+    /// Ring buffer of urgent updates.
+    UrgentUpdate urgent_[URGENT_QUEUE_SIZE];
+    /// Index of the oldest entry in urgent_.
+    unsigned urgentHead_;
+    /// Number of entries in urgent_.
+    unsigned urgentCount_;
+    /// Number of urgent packets sent since the last refresh packet.
+    unsigned urgentInARow_;
 
-    /// Offset in the refreshSources_ vector for the next loco to send.
-    size_t nextRefreshIndex_;
-    /// os time for the last time we sent a packet for loco zero.
-    long long lastCycleStart_;
+    /// The source that got the last packet.
+    PacketSource *lastSource_;
+    /// When the last packet was sent to lastSource_.
+    long long lastSendTime_;
 };
 }
 
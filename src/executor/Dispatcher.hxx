@@ -35,6 +35,8 @@
 #ifndef _EXECUTOR_DISPATCHER_HXX_
 #define _EXECUTOR_DISPATCHER_HXX_
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 
 #include "executor/Notifiable.hxx"
@@ -46,6 +48,18 @@
    invoked.
 
    Handlers are called in no particular order.
+
+   The registered handlers are stored in an immutable table. Registering or
+   unregistering a handler publishes a new copy of the table; the dispatch
+   flow reads the table without taking any lock. A table that is still being
+   iterated by the dispatch flow is reclaimed on a later registration call.
+
+   The table is indexed: handlers are grouped into buckets by their mask, and
+   buckets with many handlers (typically the exact-match handlers) get a hash
+   index keyed by the masked identifier. Looking up the handlers for a
+   message therefore only touches entries that can match, instead of all
+   registered handlers. Dispatchers with negated matching (hubs) iterate over
+   all entries as before.
  */
 template <int NUM_PRIO>
 class DispatchFlowBase : public UntypedStateFlow<QList<NUM_PRIO>>
@@ -98,7 +112,8 @@ protected:
     /// is the handler to unregister from all instances.
     void unregister_handler_all(UntypedHandler *handler);
 
-    /// Returns the current message's ID.
+    /// Returns the current message's ID. Called once per message, when the
+    /// message is dequeued.
     virtual ID get_message_id() = 0;
 
     /** Allocates an entry from lastHandlerToCall_, invoking clone() when done:
@@ -148,13 +163,16 @@ private:
     /// identifier, mask, handler pointer.
     struct HandlerInfo
     {
-        HandlerInfo() : handler(nullptr)
+        HandlerInfo() : handler(nullptr), removed(0)
         {
         }
         ID id; ///< Bits that this handler is registered for.
         ID mask; ///< Mask that should be applied for the bits check.
-        /// Handler to call. NULL if the handler has been removed.
+        /// Handler to call.
         UntypedHandler *handler;
+        /// Non-zero if the handler has been unregistered while the dispatch
+        /// flow was still iterating over this table.
+        std::atomic_uint_least8_t removed;
 
         /// Equality comparison function on the handlers. Used for remove()
         /// calls.
@@ -172,17 +190,196 @@ private:
         }
     };
 
-    /// Registered handlers.
-    vector<HandlerInfo> handlers_;
+    /// Plain copy of a handler registration, used while building a new
+    /// table.
+    struct Registration
+    {
+        ID id; ///< Bits that this handler is registered for.
+        ID mask; ///< Mask that should be applied for the bits check.
+        UntypedHandler *handler; ///< Handler to call.
+    };
+
+    /// Buckets with at least this many entries get a hash index. Smaller
+    /// buckets are scanned linearly.
+    static constexpr unsigned MIN_HASHED_BUCKET = 4;
+
+    /// A set of handlers that are registered with the same mask.
+    struct Bucket
+    {
+        /// Mask of all entries in this bucket.
+        ID mask;
+        /// Index of the first entry of this bucket in the entries array.
+        uint16_t begin;
+        /// One past the index of the last entry of this bucket.
+        uint16_t end;
+        /// Index of the first hash slot of this bucket in the slots array.
+        uint16_t slotBegin;
+        /// Log2 of the number of hash slots. 0 if this bucket has no hash
+        /// index.
+        uint8_t hashBits;
+    };
+
+    /// A snapshot of the registered handlers. Once published in table_ the
+    /// contents are never changed, except that an entry is marked as removed
+    /// when it is unregistered while the dispatch flow is using that
+    /// snapshot.
+    struct HandlerTable
+    {
+        /// Constructor.
+        /// @param n how many entries to allocate.
+        /// @param num_buckets how many buckets to allocate.
+        /// @param num_slots how many hash slots to allocate.
+        HandlerTable(size_t n, size_t num_buckets, size_t num_slots)
+            : size(n)
+            , entries(new HandlerInfo[n])
+            , numBuckets(num_buckets)
+            , buckets(new Bucket[num_buckets])
+            , slots(num_slots ? new uint16_t[num_slots] : nullptr)
+        {
+            std::fill(slots, slots + num_slots, 0);
+        }
+        ~HandlerTable()
+        {
+            delete[] entries;
+            delete[] buckets;
+            delete[] slots;
+        }
+        /// Number of entries.
+        size_t size;
+        /// Registered handlers, ordered by the mask.
+        HandlerInfo *entries;
+        /// Number of buckets.
+        size_t numBuckets;
+        /// Groups of entries with the same mask.
+        Bucket *buckets;
+        /// Hash slots for the buckets that have a hash index. Each slot holds
+        /// an entry index + 1, or 0 if the slot is empty.
+        uint16_t *slots;
+    };
+
+    /// @param count number of entries in a bucket
+    /// @return log2 of the number of hash slots to use for the bucket; this
+    /// gives at least twice as many slots as entries.
+    static uint8_t hash_bits(size_t count)
+    {
+        uint8_t bits = 1;
+        while ((1u << bits) < 2 * count)
+        {
+            ++bits;
+        }
+        return bits;
+    }
+
+    /// Computes the hash slot of an identifier.
+    /// @param key masked identifier
+    /// @param bits log2 of the number of hash slots
+    /// @return slot offset within the bucket's hash slots.
+    static unsigned hash_slot(ID key, uint8_t bits)
+    {
+        // Folds the high word in, so that 64-bit identifiers differing only
+        // in the upper bits do not all land in the same slot.
+        uint64_t k = key;
+        return (uint32_t)((uint32_t)(k ^ (k >> 32)) * 2654435761u) >>
+            (32 - bits);
+    }
+
+    /// Creates an indexed handler table.
+    /// @param regs the handlers to put into the table. Will be reordered.
+    /// @return a new table, or nullptr if regs is empty.
+    static HandlerTable *build_table(std::vector<Registration> *regs);
+
+    /// Finds the next handler entry that matches the current message. Uses
+    /// currentBucket_ and currentIndex_ as the iteration state.
+    /// @param id the identifier of the current message
+    /// @return index of the matching entry in currentTable_, or NO_MATCH.
+    size_t next_match(ID id);
+
+    /// Return value of next_match when there are no more matches.
+    static constexpr size_t NO_MATCH = (size_t)-1;
+
+    /// Builds and publishes a new table from the current table and the
+    /// pending registrations. Must be called with lock_ held.
+    void rebuild_locked();
+
+    /// Creates a copy of the current table and the pending registrations
+    /// with the given handler entries removed and publishes the result. Must
+    /// be called with lock_ held.
+    ///
+    /// @param handler handler to remove
+    /// @param id bits to remove the handler for
+    /// @param mask mask to remove the handler for
+    /// @param all if true, removes all entries of handler regardless of the
+    /// id and mask, if false, removes only the first matching entry.
+    ///
+    /// @return true if an entry was found to be removed.
+    bool remove_locked(UntypedHandler *handler, ID id, ID mask, bool all);
+
+    /// Replaces the current table with a new one. Frees the old table unless
+    /// the dispatch flow is still using it. Must be called with lock_ held.
+    ///
+    /// @param t the new table to publish. May be nullptr for empty.
+    void publish_locked(HandlerTable *t);
+
+    /// The table of currently registered handlers. nullptr if empty. Written
+    /// only with lock_ held.
+    std::atomic<HandlerTable *> table_{nullptr};
+
+    /// The table that the dispatch flow is iterating over, or nullptr when
+    /// the flow is idle. Writers must not free this table.
+    std::atomic<HandlerTable *> activeTable_{nullptr};
 
-    /// Index of the next handler to look at.
+    /// A table that was replaced while the dispatch flow was still using it;
+    /// will be freed during a later write. Protected by lock_.
+    HandlerTable *retiredTable_{nullptr};
+
+    /// Handlers registered since table_ was built. They are added to the
+    /// table at the next dispatch, so that registering many handlers does
+    /// not rebuild the table each time. Protected by lock_.
+    std::vector<Registration> pending_;
+
+    /// True if pending_ is not empty.
+    std::atomic<bool> tableStale_{false};
+
+    /// Table used for dispatching the current message. Accessed only from
+    /// the dispatch flow.
+    HandlerTable *currentTable_{nullptr};
+
+    /// Identifier of the current message.
+    ID currentId_;
+
+    /// Bucket of currentTable_ we are iterating on.
+    size_t currentBucket_;
+
+    /// Iteration position within the current bucket (or in the entire table
+    /// for negated matching). For buckets with a hash index this is the
+    /// number of probes done.
     size_t currentIndex_;
 
+    /// Entry index of the handler that the clone is being sent to.
+    size_t pendingIndex_;
+
+    /// Entry index of lastHandlerToCall_ in currentTable_.
+    size_t lastIndex_;
+
 protected:
-    /// If non-NULL we still need to call this handler.
+    /// @return the handler that we still need to call, or nullptr if there is
+    /// none or it got unregistered since we found it. Called only from the
+    /// dispatch flow.
+    UntypedHandler *last_handler()
+    {
+        if (lastHandlerToCall_ && currentTable_->entries[lastIndex_].removed)
+        {
+            lastHandlerToCall_ = nullptr;
+        }
+        return lastHandlerToCall_;
+    }
+
+    /// If non-NULL we still need to call this handler. Accessed only from the
+    /// dispatch flow; unregistering marks the entry removed instead.
     UntypedHandler *lastHandlerToCall_;
 private:
-    /// Protects handler add / remove against iteration.
+    /// Serializes handler add / remove calls. Not used by the dispatch
+    /// iteration.
     OSMutex lock_;
 };
 
@@ -266,21 +463,26 @@ protected:
         return this->message()->data()->id();
     }
 
-    /// Requests allocating a new buffer for sending off a clone.
+    /// Requests allocating a new buffer for sending off a clone. If the
+    /// message is shared, sends off a new reference instead.
     Action allocate_and_clone() OVERRIDE {
-        if (!this->lastHandlerToCall_) {
+        HandlerType* h = static_cast<HandlerType *>(this->last_handler());
+        if (!h) {
             // got unregistered.
             return call_immediately(STATE(clone_done));
         }
-        HandlerType* h = static_cast<HandlerType *>(this->lastHandlerToCall_);
+        if (shareMessage_) {
+            h->send(this->message()->ref());
+            return call_immediately(STATE(clone_done));
+        }
         return allocate_and_call(h, STATE(clone));
     }
 
     /// Takes the allocated new buffer, copies the message into it and sends
     /// off to the clone target. @return next action.
     Action clone() {
-        HandlerType* h = static_cast<HandlerType *>(this->lastHandlerToCall_);
-        if (!this->lastHandlerToCall_) {  // got unregistered
+        HandlerType* h = static_cast<HandlerType *>(this->last_handler());
+        if (!h) {  // got unregistered
             BufferBase* b;
             this->cast_allocation_result(&b);
             if (b) this->get_allocation_result(h)->unref();
@@ -299,6 +501,11 @@ protected:
         HandlerType* h = static_cast<HandlerType *>(this->lastHandlerToCall_);
         h->send(this->transfer_message());
     }
+
+    /// If true, every handler gets the same buffer (with an added reference)
+    /// instead of a copy of the message. Handlers must then not modify the
+    /// incoming message.
+    bool shareMessage_{false};
 };
 
 
@@ -316,21 +523,113 @@ template<int NUM_PRIO>
 DispatchFlowBase<NUM_PRIO>::~DispatchFlowBase()
 {
     HASSERT(this->is_waiting());
+    delete table_.load();
+    delete retiredTable_;
 }
 
 template<int NUM_PRIO>
 size_t DispatchFlowBase<NUM_PRIO>::size()
 {
     OSMutexLock h(&lock_);
-    size_t ret = 0;
-    for (auto &h : handlers_)
+    HandlerTable *t = table_.load();
+    return (t ? t->size : 0) + pending_.size();
+}
+
+template<int NUM_PRIO>
+void DispatchFlowBase<NUM_PRIO>::publish_locked(HandlerTable *t)
+{
+    HandlerTable *old = table_.load(std::memory_order_relaxed);
+    table_.store(t);
+    // After the store above the dispatch flow cannot pick up the old table
+    // anymore, so only activeTable_ may hold on to it.
+    HandlerTable *active = activeTable_.load();
+    if (retiredTable_ && retiredTable_ != active)
+    {
+        delete retiredTable_;
+        retiredTable_ = nullptr;
+    }
+    if (old && old == active)
     {
-        if (h.handler)
+        HASSERT(!retiredTable_);
+        retiredTable_ = old;
+    }
+    else
+    {
+        delete old;
+    }
+}
+
+template<int NUM_PRIO>
+typename DispatchFlowBase<NUM_PRIO>::HandlerTable *
+DispatchFlowBase<NUM_PRIO>::build_table(std::vector<Registration> *regs)
+{
+    if (regs->empty())
+    {
+        return nullptr;
+    }
+    HASSERT(regs->size() < 0xFFFF);
+    std::stable_sort(regs->begin(), regs->end(),
+        [](const Registration &a, const Registration &b) {
+            return a.mask < b.mask;
+        });
+    // Counts the buckets and the hash slots needed.
+    size_t num_buckets = 0;
+    size_t num_slots = 0;
+    for (size_t i = 0; i < regs->size();)
+    {
+        size_t j = i;
+        while (j < regs->size() && (*regs)[j].mask == (*regs)[i].mask)
+        {
+            ++j;
+        }
+        ++num_buckets;
+        if (j - i >= MIN_HASHED_BUCKET)
         {
-            ++ret;
+            num_slots += 1u << hash_bits(j - i);
         }
+        i = j;
+    }
+    HASSERT(num_slots < 0xFFFF);
+    HandlerTable *t = new HandlerTable(regs->size(), num_buckets, num_slots);
+    for (size_t i = 0; i < regs->size(); ++i)
+    {
+        t->entries[i].id = (*regs)[i].id;
+        t->entries[i].mask = (*regs)[i].mask;
+        t->entries[i].handler = (*regs)[i].handler;
     }
-    return ret;
+    size_t next_slot = 0;
+    Bucket *b = t->buckets;
+    for (size_t i = 0; i < regs->size(); ++b)
+    {
+        size_t j = i;
+        while (j < regs->size() && (*regs)[j].mask == (*regs)[i].mask)
+        {
+            ++j;
+        }
+        b->mask = (*regs)[i].mask;
+        b->begin = i;
+        b->end = j;
+        b->slotBegin = next_slot;
+        b->hashBits = 0;
+        if (j - i >= MIN_HASHED_BUCKET)
+        {
+            b->hashBits = hash_bits(j - i);
+            unsigned slot_mask = (1u << b->hashBits) - 1;
+            uint16_t *slots = t->slots + next_slot;
+            for (size_t k = i; k < j; ++k)
+            {
+                unsigned h = hash_slot(t->entries[k].id & b->mask, b->hashBits);
+                while (slots[h])
+                {
+                    h = (h + 1) & slot_mask;
+                }
+                slots[h] = k + 1;
+            }
+            next_slot += slot_mask + 1;
+        }
+        i = j;
+    }
+    return t;
 }
 
 template<int NUM_PRIO>
@@ -338,18 +637,81 @@ void DispatchFlowBase<NUM_PRIO>::register_handler(UntypedHandler *handler,
                                                   ID id, ID mask)
 {
     OSMutexLock h(&lock_);
-    size_t idx = 0;
-    while (idx < handlers_.size() && handlers_[idx].handler)
+    pending_.push_back({id, mask, handler});
+    tableStale_.store(true);
+}
+
+template<int NUM_PRIO>
+void DispatchFlowBase<NUM_PRIO>::rebuild_locked()
+{
+    HandlerTable *old = table_.load(std::memory_order_relaxed);
+    size_t old_size = old ? old->size : 0;
+    std::vector<Registration> regs;
+    regs.reserve(old_size + pending_.size());
+    for (size_t i = 0; i < old_size; ++i)
     {
-        ++idx;
+        auto &e = old->entries[i];
+        regs.push_back({e.id, e.mask, e.handler});
     }
-    if (idx >= handlers_.size())
+    regs.insert(regs.end(), pending_.begin(), pending_.end());
+    pending_.clear();
+    tableStale_.store(false);
+    publish_locked(build_table(&regs));
+}
+
+template<int NUM_PRIO>
+bool DispatchFlowBase<NUM_PRIO>::remove_locked(
+    UntypedHandler *handler, ID id, ID mask, bool all)
+{
+    HandlerTable *old = table_.load(std::memory_order_relaxed);
+    size_t old_size = old ? old->size : 0;
+    std::vector<Registration> regs;
+    regs.reserve(old_size + pending_.size());
+    for (size_t i = 0; i < old_size; ++i)
     {
-        handlers_.resize(handlers_.size() + 1);
+        auto &e = old->entries[i];
+        regs.push_back({e.id, e.mask, e.handler});
     }
-    handlers_[idx].handler = handler;
-    handlers_[idx].id = id;
-    handlers_[idx].mask = mask;
+    regs.insert(regs.end(), pending_.begin(), pending_.end());
+    size_t num_removed = 0;
+    size_t num_kept = 0;
+    for (size_t i = 0; i < regs.size(); ++i)
+    {
+        auto &e = regs[i];
+        if ((all || !num_removed) &&
+            (all ? e.handler == handler
+                 : (e.id == id && e.mask == mask && e.handler == handler)))
+        {
+            ++num_removed;
+            continue;
+        }
+        regs[num_kept++] = e;
+    }
+    regs.resize(num_kept);
+    if (!num_removed)
+    {
+        return false;
+    }
+    pending_.clear();
+    tableStale_.store(false);
+    HandlerTable *t = build_table(&regs);
+    publish_locked(t);
+    // The dispatch flow might be in the middle of iterating over an older
+    // table. We clear the removed handler there to ensure that it does not
+    // get called after the unregister call returns.
+    HandlerTable *active = activeTable_.load();
+    if (active && active != t)
+    {
+        for (size_t i = 0; i < active->size; ++i)
+        {
+            auto &e = active->entries[i];
+            if (all ? e.handler == handler : e.Equals(id, mask, handler))
+            {
+                e.removed = 1;
+            }
+        }
+    }
+    return true;
 }
 
 template<int NUM_PRIO>
@@ -358,23 +720,10 @@ DispatchFlowBase<NUM_PRIO>::unregister_handler(UntypedHandler *handler,
                                                ID id, ID mask)
 {
     OSMutexLock h(&lock_);
-    /// @todo(balazs.racz) optimize by looking at the current index - 1.
-    size_t idx = 0;
-    while (idx < handlers_.size() && !handlers_[idx].Equals(id, mask, handler))
-    {
-        ++idx;
-    }
+    bool found = remove_locked(handler, id, mask, false);
     // Checks that we found the thing to unregister.
-    HASSERT(idx < handlers_.size() &&
+    HASSERT(found &&
             "Tried to unregister a handler not previously registered.");
-    if (lastHandlerToCall_ == handlers_[idx].handler) {
-        lastHandlerToCall_ = nullptr;
-    }
-    handlers_[idx].handler = nullptr;
-    if (idx == handlers_.size() - 1)
-    {
-        handlers_.resize(handlers_.size() - 1);
-    }
 }
 
 template<int NUM_PRIO>
@@ -382,84 +731,138 @@ void DispatchFlowBase<NUM_PRIO>::unregister_handler_all(
     UntypedHandler *handler)
 {
     OSMutexLock h(&lock_);
-    for (size_t i = 0; i < handlers_.size(); ++i)
-    {
-        if (handlers_[i].handler == handler)
-        {
-            handlers_[i].handler = nullptr;
-        }
-    }
-    while (!handlers_.empty() && handlers_.back().handler == nullptr)
-    {
-        handlers_.pop_back();
-    }
+    remove_locked(handler, 0, 0, true);
 }
 
 template<int NUM_PRIO>
 StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::entry()
 {
+    currentId_ = get_message_id();
+    currentBucket_ = 0;
     currentIndex_ = 0;
     lastHandlerToCall_ = nullptr;
+    if (tableStale_.load())
+    {
+        // Picks up the handlers registered since the last dispatch.
+        OSMutexLock h(&lock_);
+        if (tableStale_.load())
+        {
+            rebuild_locked();
+        }
+    }
+    // Announces which table we are going to use. The loop ensures that a
+    // concurrent writer has seen the announcement before it could have
+    // freed the table.
+    HandlerTable *t;
+    do
+    {
+        t = table_.load();
+        activeTable_.store(t);
+    } while (t != table_.load());
+    currentTable_ = t;
     return call_immediately(STATE(iterate));
 }
 
 template<int NUM_PRIO>
-StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iterate()
+size_t DispatchFlowBase<NUM_PRIO>::next_match(ID id)
 {
-    ID id = get_message_id();
+    HandlerTable *t = currentTable_;
+    if (!t)
+    {
+        return NO_MATCH;
+    }
+    if (negateMatch_)
     {
-        // @todo(balazs.racz) make the registered handlers structure for the
-        // dispatcher lock-free. This mutex here is very expensive.
-        OSMutexLock l(&lock_);
-        for (; currentIndex_ < handlers_.size(); ++currentIndex_)
+        while (currentIndex_ < t->size)
         {
-            auto &h = handlers_[currentIndex_];
-            if (!h.handler)
+            auto &h = t->entries[currentIndex_++];
+            if ((id & h.mask) != (h.id & h.mask))
             {
-                continue;
+                return currentIndex_ - 1;
             }
-            if (negateMatch_ && (id & h.mask) == (h.id & h.mask))
+        }
+        return NO_MATCH;
+    }
+    for (; currentBucket_ < t->numBuckets; ++currentBucket_, currentIndex_ = 0)
+    {
+        const Bucket &b = t->buckets[currentBucket_];
+        ID key = id & b.mask;
+        if (!b.hashBits)
+        {
+            while (b.begin + currentIndex_ < b.end)
             {
-                continue;
+                size_t idx = b.begin + currentIndex_++;
+                if ((t->entries[idx].id & b.mask) == key)
+                {
+                    return idx;
+                }
             }
-            if ((!negateMatch_) && (id & h.mask) != (h.id & h.mask))
+            continue;
+        }
+        unsigned slot_mask = (1u << b.hashBits) - 1;
+        unsigned h = hash_slot(key, b.hashBits);
+        while (true)
+        {
+            uint16_t slot =
+                t->slots[b.slotBegin + ((h + currentIndex_) & slot_mask)];
+            if (!slot)
             {
-                continue;
+                break;
             }
-            // At this point: we have another handler.
-            if (!lastHandlerToCall_)
+            ++currentIndex_;
+            if ((t->entries[slot - 1].id & b.mask) == key)
             {
-                // This was the first we found.
-                lastHandlerToCall_ = handlers_[currentIndex_].handler;
-                continue;
-            }            
-            break;
+                return slot - 1;
+            }
         }
     }
-    if (currentIndex_ >= handlers_.size())
+    return NO_MATCH;
+}
+
+template<int NUM_PRIO>
+StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iterate()
+{
+    size_t idx;
+    while ((idx = next_match(currentId_)) != NO_MATCH)
     {
-        return iteration_done();
+        auto &h = currentTable_->entries[idx];
+        if (h.removed)
+        {
+            continue;
+        }
+        // At this point: we have another handler.
+        if (!lastHandlerToCall_)
+        {
+            // This was the first we found.
+            lastHandlerToCall_ = h.handler;
+            lastIndex_ = idx;
+            continue;
+        }
+        // Now: we have at least two different handler. We need to clone the
+        // message. We use the pool of the last handler to call by default.
+        pendingIndex_ = idx;
+        return allocate_and_clone();
     }
-    // Now: we have at least two different handler. We need to clone the
-    // message. We use the pool of the last handler to call by default.
-    return allocate_and_clone();
+    return iteration_done();
 }
 
 template<int NUM_PRIO>
 StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::clone_done()
 {
-    lastHandlerToCall_ = handlers_[currentIndex_].handler;
-    ++currentIndex_;
+    lastHandlerToCall_ = currentTable_->entries[pendingIndex_].handler;
+    lastIndex_ = pendingIndex_;
     return call_immediately(STATE(iterate));
 }
 
 template<int NUM_PRIO>
 StateFlowBase::Action DispatchFlowBase<NUM_PRIO>::iteration_done()
 {
-    if (lastHandlerToCall_)
+    if (last_handler())
     {
         send_transfer();
     }
+    currentTable_ = nullptr;
+    activeTable_.store(nullptr);
     return release_and_exit();
 }
 
@@ -46,6 +46,11 @@
 #include <sys/select.h>
 #endif
 
+#if OPENMRN_HAVE_EPOLL
+#include <string.h>
+#include <sys/epoll.h>
+#endif
+
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
@@ -58,6 +63,7 @@ extern "C" {
 }
 #endif
 
+#include "executor/ExecutorProfiler.hxx"
 #include "executor/Service.hxx"
 #include "nmranet_config.h"
 
@@ -70,7 +76,7 @@ Executable::~Executable() {
 
 /** Constructor.
  */
-ExecutorBase::ExecutorBase()
+ExecutorBase::ExecutorBase(bool use_select)
     : name_(NULL) /** @todo (Stuart Baker) is "name" still in use? */
     , activeTimers_(this)
     , done_(0)
@@ -81,6 +87,13 @@ ExecutorBase::ExecutorBase()
     FD_ZERO(&selectWrite_);
     FD_ZERO(&selectExcept_);
     selectNFds_ = 0;
+#if OPENMRN_HAVE_EPOLL
+    if (use_select && config_executor_use_epoll() == CONSTANT_TRUE)
+    {
+        // Falls back to select() if this fails.
+        epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    }
+#endif
 }
 
 /** Lookup an executor by its name.
@@ -150,7 +163,10 @@ public:
 
 void ExecutorBase::sync_run(std::function<void()> fn)
 {
-    if (os_thread_self() == selectHelper_.main_thread())
+    // The thread handle is set while an executor without its own thread
+    // (e.g. a pool strand) is running its loop.
+    if (os_thread_self() == selectHelper_.main_thread() ||
+        os_thread_self() == thread_handle())
     {
         // run inline.
         fn();
@@ -162,6 +178,48 @@ void ExecutorBase::sync_run(std::function<void()> fn)
     }
 }
 
+void ExecutorBase::run_executable(Executable *msg, unsigned priority)
+{
+    current_ = msg;
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+    ExecutorProfiler *p = profiler_.load(std::memory_order_relaxed);
+    if (p)
+    {
+        p->run(msg, priority);
+    }
+    else
+#endif
+    {
+        msg->run();
+    }
+    current_ = nullptr;
+}
+
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+void ExecutorBase::record_enqueue(ExecutorProfiler *p, Executable *msg)
+{
+    p->enqueued(msg);
+}
+
+void ExecutorBase::set_profiler(ExecutorProfiler *profiler)
+{
+    if (profiler)
+    {
+        // Timestamps left over from an earlier attachment would show up as
+        // bogus queue wait times.
+        profiler->clear_enqueued();
+    }
+    if (!started_ || done_)
+    {
+        profiler_ = profiler;
+    }
+    else
+    {
+        sync_run([this, profiler]() { profiler_ = profiler; });
+    }
+}
+#endif
+
 bool ExecutorBase::loop_once()
 {
     ScopedSetThreadHandle h(this);
@@ -178,9 +236,7 @@ bool ExecutorBase::loop_once()
         done_ = 1;
         return false;
     }
-    current_ = msg;
-    msg->run();
-    current_ = nullptr;
+    run_executable(msg, priority);
     return true;
 }
 
@@ -202,9 +258,7 @@ long long ICACHE_FLASH_ATTR  ExecutorBase::loop_some() {
         }
         if (msg != NULL)
         {
-            current_ = msg;
-            msg->run();
-            current_ = nullptr;
+            run_executable(msg, priority);
         }
     }
     // Still stuff pending to run.
@@ -303,7 +357,19 @@ void *ExecutorBase::entry()
         if (!selectPrescaler_ || ((msg = next(&priority)) == nullptr))
         {
             long long wait_length = activeTimers_.get_next_timeout();
-            wait_with_select(wait_length);
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+            ExecutorProfiler *p = profiler_.load(std::memory_order_relaxed);
+            if (p)
+            {
+                long long start = os_get_time_monotonic();
+                wait_with_select(wait_length);
+                p->record_select_wait(os_get_time_monotonic() - start);
+            }
+            else
+#endif
+            {
+                wait_with_select(wait_length);
+            }
             selectPrescaler_ = config_executor_select_prescaler();
             msg = next(&priority);
         }
@@ -320,9 +386,7 @@ void *ExecutorBase::entry()
         if (msg != NULL)
         {
             ++sequence_;
-            current_ = msg;
-            msg->run();
-            current_ = nullptr;
+            run_executable(msg, priority);
         }
     }
 
@@ -331,6 +395,32 @@ void *ExecutorBase::entry()
 
 void ExecutorBase::select(Selectable *job)
 {
+#if OPENMRN_HAVE_EPOLL
+    if (epollFd_ >= 0)
+    {
+        int fd = job->fd_;
+        if (fd >= (int)epollSlots_.size())
+        {
+            epollSlots_.resize(fd + 1);
+        }
+        Selectable **slot = &epollSlots_[fd].jobs[job->selectType_ - 1];
+        if (*slot)
+        {
+            LOG(FATAL,
+                "Multiple Selectables are waiting for the same fd %d type %u",
+                fd, job->selectType_);
+        }
+        HASSERT(!job->next);
+        *slot = job;
+        if (!epoll_update(fd))
+        {
+            // select() reports such fds as always ready.
+            *slot = nullptr;
+            add(job->wakeup_, job->priority_);
+        }
+        return;
+    }
+#endif
     fd_set *s = get_select_set(job->type());
     int fd = job->fd_;
     if (FD_ISSET(fd, s))
@@ -351,6 +441,13 @@ void ExecutorBase::select(Selectable *job)
 
 bool ExecutorBase::is_selected(Selectable *job)
 {
+#if OPENMRN_HAVE_EPOLL
+    if (epollFd_ >= 0)
+    {
+        return job->fd_ < epollSlots_.size() &&
+            epollSlots_[job->fd_].jobs[job->selectType_ - 1] != nullptr;
+    }
+#endif
     fd_set *s = get_select_set(job->type());
     int fd = job->fd_;
     return FD_ISSET(fd, s);
@@ -358,6 +455,21 @@ bool ExecutorBase::is_selected(Selectable *job)
 
 void ExecutorBase::unselect(Selectable *job)
 {
+#if OPENMRN_HAVE_EPOLL
+    if (epollFd_ >= 0)
+    {
+        if (!is_selected(job))
+        {
+            LOG(FATAL, "Tried to remove a non-active selectable: fd %d type %u",
+                job->fd_, job->selectType_);
+        }
+        // The kernel registration is left alone. Events arriving for the
+        // removed job will be ignored, and the next select() updates the
+        // registration.
+        epollSlots_[job->fd_].jobs[job->selectType_ - 1] = nullptr;
+        return;
+    }
+#endif
     fd_set *s = get_select_set(job->type());
     int fd = job->fd_;
     if (!FD_ISSET(fd, s))
@@ -400,6 +512,13 @@ void ExecutorBase::wait_with_select(long long wait_length)
     {
         wait_length = max_sleep;
     }
+#if OPENMRN_HAVE_EPOLL
+    if (epollFd_ >= 0)
+    {
+        wait_with_epoll(wait_length);
+        return;
+    }
+#endif
     int ret = selectHelper_.select(selectNFds_, &fd_r, &fd_w, &fd_x, wait_length);
     if (ret <= 0) {
         return; // nothing to do
@@ -425,6 +544,78 @@ void ExecutorBase::wait_with_select(long long wait_length)
     selectNFds_ = max_fd;
 }
 
+#if OPENMRN_HAVE_EPOLL
+bool ExecutorBase::epoll_update(int fd)
+{
+    EpollSlot *s = &epollSlots_[fd];
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLET;
+    if (s->jobs[Selectable::READ - 1])
+    {
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (s->jobs[Selectable::WRITE - 1])
+    {
+        ev.events |= EPOLLOUT;
+    }
+    if (s->jobs[Selectable::EXCEPT - 1])
+    {
+        ev.events |= EPOLLPRI;
+    }
+    ev.data.fd = fd;
+    // A MOD re-evaluates the readiness, so we get an event if the fd is
+    // already ready, even if there was no edge since we last looked.
+    if (s->registered && ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) == 0)
+    {
+        return true;
+    }
+    // The kernel drops the registration when an fd is closed, so a reused fd
+    // number might need to be added again.
+    if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) == 0 ||
+        (errno == EEXIST && ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) == 0))
+    {
+        s->registered = true;
+        return true;
+    }
+    LOG(VERBOSE, "epoll_ctl failed for fd %d: %s", fd, strerror(errno));
+    s->registered = false;
+    return false;
+}
+
+void ExecutorBase::wait_with_epoll(long long wait_length)
+{
+    static constexpr int MAX_EVENTS = 32;
+    struct epoll_event events[MAX_EVENTS];
+    int ret =
+        selectHelper_.epoll_wait(epollFd_, events, MAX_EVENTS, wait_length);
+    for (int i = 0; i < ret; ++i)
+    {
+        int fd = events[i].data.fd;
+        uint32_t ev = events[i].events;
+        if (fd >= (int)epollSlots_.size())
+        {
+            continue;
+        }
+        EpollSlot *s = &epollSlots_[fd];
+        // Matches select(), which reports errors and hangups as the fd being
+        // both readable and writable.
+        const uint32_t err = EPOLLERR | EPOLLHUP;
+        const uint32_t masks[3] = {
+            EPOLLIN | EPOLLRDHUP | err, EPOLLOUT | err, EPOLLPRI};
+        for (unsigned t = 0; t < 3; ++t)
+        {
+            Selectable *job = s->jobs[t];
+            if (job && (ev & masks[t]))
+            {
+                s->jobs[t] = nullptr;
+                add(job->wakeup_, job->priority_);
+            }
+        }
+    }
+}
+#endif // OPENMRN_HAVE_EPOLL
+
 #endif
 
 #if defined(ARDUINO)
@@ -458,4 +649,10 @@ ExecutorBase::~ExecutorBase()
     {
         shutdown();
     }
+#if OPENMRN_HAVE_EPOLL
+    if (epollFd_ >= 0)
+    {
+        ::close(epollFd_);
+    }
+#endif
 }
@@ -38,11 +38,13 @@
 
 #include <functional>
 #include <atomic>
+#include <vector>
 
 #include "executor/Executable.hxx"
 #include "executor/Notifiable.hxx"
 #include "executor/Selectable.hxx"
 #include "executor/Timer.hxx"
+#include "openmrn_features.h"
 #include "utils/Queue.hxx"
 #include "utils/SimpleQueue.hxx"
 #include "utils/LinkedObject.hxx"
@@ -57,6 +59,7 @@ extern "C" {
 #endif
 
 class ActiveTimers;
+class ExecutorProfiler;
 
 /** This class implements an execution of tasks pulled off an input queue.
  */
@@ -64,8 +67,11 @@ class ExecutorBase : protected OSThread, protected Executable, public LinkedObje
 {
 public:
     /** Constructor.
+     * @param use_select false if this executor will never call select(),
+     * e.g. because it has no thread of its own. Then no resources are
+     * allocated for the select backend.
      */
-    ExecutorBase();
+    ExecutorBase(bool use_select = true);
 
     /** Destructor.
      */
@@ -166,7 +172,25 @@ public:
     /// Helper function for debugging and tracing.
     /// @return currently running executable or nullptr if none active.
     Executable* current() { return current_; }
-    
+
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+    /// Starts or stops collecting run-time statistics on this executor. When
+    /// called from a thread other than the executor's, returns only after the
+    /// executor thread has stopped using the previous profiler.
+    ///
+    /// @param profiler where to record the statistics, or nullptr to turn off
+    /// profiling. Ownership is not transferred; must stay alive until it is
+    /// replaced or the executor is shut down.
+    void set_profiler(ExecutorProfiler *profiler);
+
+    /// @return the profiler recording this executor, or nullptr if profiling
+    /// is off.
+    ExecutorProfiler *profiler()
+    {
+        return profiler_.load(std::memory_order_relaxed);
+    }
+#endif
+
 protected:
     /** Thread entry point.
      * @return Should never return
@@ -178,6 +202,22 @@ protected:
     /** Helper object for interruptible select calls. */
     OSSelectWakeup selectHelper_;
 
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+    /// Tells the profiler, if there is one, that an executable was added to
+    /// the queue. Called from add(). @param msg the executable added.
+    void profile_enqueue(Executable *msg)
+    {
+        ExecutorProfiler *p = profiler_.load(std::memory_order_relaxed);
+        if (p)
+        {
+            record_enqueue(p, msg);
+        }
+    }
+
+    /// Profiler to record the run times into, nullptr if profiling is off.
+    std::atomic<ExecutorProfiler *> profiler_ {nullptr};
+#endif
+
 private:
     /** Retrieve an item from the front of the queue.
      * @param priority pass back the priority of the queue pulled from
@@ -185,6 +225,20 @@ private:
      */
     virtual Executable *next(unsigned *priority) = 0;
 
+    /// Runs an executable taken from the queue, and records its run time if
+    /// profiling is enabled.
+    ///
+    /// @param msg the executable to run.
+    /// @param priority the priority band it was taken from.
+    void run_executable(Executable *msg, unsigned priority);
+
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+    /// Out-of-line part of profile_enqueue(), so that this header does not
+    /// need the profiler's declaration. @param p the profiler, @param msg the
+    /// executable added.
+    static void record_enqueue(ExecutorProfiler *p, Executable *msg);
+#endif
+
     /** Executes a select call, and schedules any necessary executables based
      * on the return. Will not sleep at all if not empty, otherwise sleeps at
      * most next_timer_nsec nanoseconds (from now).
@@ -192,6 +246,32 @@ private:
      * @param next_timer_nsec is the maximum time to sleep in nanoseconds. */
     void wait_with_select(long long next_timer_nsec);
 
+#if OPENMRN_HAVE_EPOLL
+    /// Selectables waiting for a given file descriptor with the epoll
+    /// backend.
+    struct EpollSlot
+    {
+        /// Jobs waiting for READ, WRITE and EXCEPT, respectively.
+        Selectable *jobs[3] = {nullptr, nullptr, nullptr};
+        /// True if the fd was added to the epoll instance.
+        bool registered = false;
+    };
+
+    /// Tells the kernel which events we are waiting for on an fd. Also
+    /// re-arms the edge-triggered registration.
+    ///
+    /// @param fd the file descriptor whose slot was changed.
+    ///
+    /// @return false if the fd cannot be used with epoll (e.g. a regular
+    /// file).
+    bool epoll_update(int fd);
+
+    /// Waits for the epoll events and schedules the woken up executables.
+    ///
+    /// @param wait_length is the maximum time to sleep in nanoseconds.
+    void wait_with_epoll(long long wait_length);
+#endif
+
     /// Helper function.
     ///
     /// @param type a select type: READ, WRITE or EXCEPT
@@ -229,6 +309,12 @@ private:
     int selectNFds_;
     /** Head of the linked list for the select calls. */
     TypedQueue<Selectable> selectables_;
+#if OPENMRN_HAVE_EPOLL
+    /// epoll instance, or -1 if the select() backend is used.
+    int epollFd_{-1};
+    /// Waiting selectables, indexed by fd.
+    std::vector<EpollSlot> epollSlots_;
+#endif
 
     /** Set to 1 when the executor thread has exited and it is safe to delete
      * *this. */
@@ -305,6 +391,9 @@ public:
      */
     void add(Executable *msg, unsigned priority = UINT_MAX) OVERRIDE
     {
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+        profile_enqueue(msg);
+#endif
         queue_.insert(
             msg, priority >= NUM_PRIO ? NUM_PRIO - 1 : priority);
 #ifdef ESP_NONOS
@@ -372,8 +461,14 @@ private:
 
     DISALLOW_COPY_AND_ASSIGN(Executor);
 
+#if OPENMRN_FEATURE_LOCKFREE_QUEUE
+    /// Internal queue of executables waiting to be scheduled. Only the
+    /// executor thread takes items out.
+    QListMpsc<NUM_PRIO> queue_;
+#else
     /// Internal queue of executables waiting to be scheduled.
     QListProtected<NUM_PRIO> queue_;
+#endif
 };
 
 /** This class can be given an executor, and will notify itself when that
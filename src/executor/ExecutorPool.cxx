@@ -0,0 +1,363 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ExecutorPool.cxx
+ *
+ * A group of worker threads that run many executors (strands) with work
+ * stealing.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#include "executor/ExecutorPool.hxx"
+
+#if OPENMRN_FEATURE_EXECUTOR_POOL
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <pthread.h>
+#include <thread>
+
+/// One thread of the pool with its queue of ready strands. The worker takes
+/// strands from the front of its own queue; other workers steal from the
+/// back.
+class ExecutorPool::Worker
+{
+public:
+    /// Constructor. @param pool parent. @param index position in the pool.
+    Worker(ExecutorPool *pool, unsigned index)
+        : pool_(pool)
+        , index_(index)
+    {
+    }
+
+    /// @return the first strand of the ready queue, or nullptr if empty.
+    Strand *pop()
+    {
+        OSMutexLock h(&lock_);
+        if (ready_.empty())
+        {
+            return nullptr;
+        }
+        Strand *s = ready_.front();
+        ready_.pop_front();
+        return s;
+    }
+
+    /// Starts the thread. @param name thread name.
+    void start(const char *name)
+    {
+        // Not created with os_thread_create, because those threads are
+        // detached and cannot be joined.
+        thread_ = std::thread(&Worker::entry, this);
+#if OPENMRN_HAVE_PTHREAD_SETNAME
+        pthread_setname_np(thread_.native_handle(), name);
+#endif
+    }
+
+    /// Thread body.
+    void entry()
+    {
+        currentWorker_ = this;
+        while (Strand *s = pool_->take(this))
+        {
+            s->process();
+        }
+        currentWorker_ = nullptr;
+    }
+
+    /// Parent.
+    ExecutorPool *pool_;
+    /// Position of this worker in the pool.
+    unsigned index_;
+    /// Protects ready_.
+    OSMutex lock_;
+    /// Strands ready to run.
+    std::deque<Strand *> ready_;
+    /// The thread running entry().
+    std::thread thread_;
+};
+
+thread_local ExecutorPool::Worker *ExecutorPool::currentWorker_ = nullptr;
+
+/// Heap order of the wakeups: the earliest time at the front.
+typedef std::greater<std::pair<long long, ExecutorPool::Strand *>> WakeupOrder;
+
+ExecutorPool::ExecutorPool(const char *name, unsigned num_workers,
+    int priority, size_t stack_size)
+{
+    HASSERT(num_workers > 0);
+    for (unsigned i = 0; i < num_workers; ++i)
+    {
+        workers_.emplace_back(new Worker(this, i));
+    }
+    for (auto &w : workers_)
+    {
+        w->start(name);
+    }
+}
+
+ExecutorPool::~ExecutorPool()
+{
+    exiting_ = true;
+    for (unsigned i = 0; i < workers_.size(); ++i)
+    {
+        sem_.post();
+    }
+    for (auto &w : workers_)
+    {
+        w->thread_.join();
+    }
+}
+
+void ExecutorPool::push(Strand *s)
+{
+    Worker *w = currentWorker_;
+    if (!w || w->pool_ != this)
+    {
+        w = workers_[nextWorker_.fetch_add(1, std::memory_order_relaxed) %
+            workers_.size()].get();
+    }
+    {
+        OSMutexLock h(&w->lock_);
+        w->ready_.push_back(s);
+    }
+    // Pairs with the increment in take(): either the sleeping worker sees the
+    // new strand in its last scan, or we see the sleeping worker here.
+    if (numSleeping_.load())
+    {
+        sem_.post();
+    }
+}
+
+ExecutorPool::Strand *ExecutorPool::take(Worker *w)
+{
+    while (true)
+    {
+        long long wait = fire_timers();
+        Strand *s = w->pop();
+        if (!s)
+        {
+            s = steal(w);
+        }
+        if (s || exiting_)
+        {
+            return s;
+        }
+        ++numSleeping_;
+        s = w->pop();
+        if (!s)
+        {
+            s = steal(w);
+        }
+        if (!s && !exiting_)
+        {
+            sem_.timedwait(wait);
+        }
+        --numSleeping_;
+        if (s)
+        {
+            return s;
+        }
+    }
+}
+
+ExecutorPool::Strand *ExecutorPool::steal(Worker *w)
+{
+    unsigned n = workers_.size();
+    for (unsigned i = 1; i < n; ++i)
+    {
+        Worker *victim = workers_[(w->index_ + i) % n].get();
+        OSMutexLock h(&victim->lock_);
+        if (!victim->ready_.empty())
+        {
+            Strand *s = victim->ready_.back();
+            victim->ready_.pop_back();
+            ++numSteals_;
+            return s;
+        }
+    }
+    return nullptr;
+}
+
+long long ExecutorPool::fire_timers()
+{
+    long long now = os_get_time_monotonic();
+    long long next = nextWakeup_.load(std::memory_order_relaxed);
+    if (next > now)
+    {
+        return std::min(next - now, SEC_TO_NSEC(3600));
+    }
+    OSMutexLock h(&timerLock_);
+    while (!wakeups_.empty() && wakeups_.front().first <= now)
+    {
+        auto e = wakeups_.front();
+        std::pop_heap(wakeups_.begin(), wakeups_.end(), WakeupOrder());
+        wakeups_.pop_back();
+        if (e.second->wakeAt_ == e.first)
+        {
+            // The strand will recompute its timers when it runs.
+            e.second->wakeAt_ = 0;
+            e.second->schedule();
+        }
+    }
+    next = wakeups_.empty() ? INT64_MAX : wakeups_.front().first;
+    nextWakeup_ = next;
+    return std::min(next - now, SEC_TO_NSEC(3600));
+}
+
+void ExecutorPool::schedule_wakeup(Strand *s, long long when)
+{
+    OSMutexLock h(&timerLock_);
+    if (s->state_ & Strand::DRAINING)
+    {
+        // The strand is being destroyed; its timers will never fire.
+        return;
+    }
+    if (s->wakeAt_ && s->wakeAt_ <= when)
+    {
+        // An earlier wakeup is pending already.
+        return;
+    }
+    // Any later entry of this strand stays in the heap, but becomes stale.
+    s->wakeAt_ = when;
+    wakeups_.emplace_back(when, s);
+    std::push_heap(wakeups_.begin(), wakeups_.end(), WakeupOrder());
+    if (when < nextWakeup_)
+    {
+        nextWakeup_ = when;
+    }
+}
+
+void ExecutorPool::cancel_wakeup(Strand *s)
+{
+    s->wakeAt_ = 0;
+    wakeups_.erase(std::remove_if(wakeups_.begin(), wakeups_.end(),
+                       [s](const std::pair<long long, Strand *> &e) {
+                           return e.second == s;
+                       }),
+        wakeups_.end());
+    std::make_heap(wakeups_.begin(), wakeups_.end(), WakeupOrder());
+    nextWakeup_ = wakeups_.empty() ? INT64_MAX : wakeups_.front().first;
+}
+
+ExecutorPool::Strand::Strand(ExecutorPool *pool)
+    : ExecutorBase(false)
+    , pool_(pool)
+{
+}
+
+ExecutorPool::Strand::~Strand()
+{
+    OSSem drained;
+    uint8_t s;
+    {
+        // With the timer lock held and the wakeups removed, the pool has no
+        // more way to schedule this strand. The DRAINING flag keeps the
+        // running worker from adding new wakeups.
+        OSMutexLock h(&pool_->timerLock_);
+        pool_->cancel_wakeup(this);
+        drained_ = &drained;
+        s = state_.fetch_or(DRAINING);
+    }
+    if (s != IDLE)
+    {
+        drained.wait();
+    }
+}
+
+void ExecutorPool::Strand::schedule()
+{
+    uint8_t s = state_.load();
+    while (true)
+    {
+        uint8_t flags = s & DRAINING;
+        if ((s & ~DRAINING) == IDLE)
+        {
+            if (state_.compare_exchange_weak(s, QUEUED | flags))
+            {
+                pool_->push(this);
+                return;
+            }
+        }
+        else if ((s & ~DRAINING) == RUNNING)
+        {
+            if (state_.compare_exchange_weak(s, RUNNING_NOTIFIED | flags))
+            {
+                return;
+            }
+        }
+        else
+        {
+            // Already queued, or the running worker will look again.
+            return;
+        }
+    }
+}
+
+void ExecutorPool::Strand::process()
+{
+    set_state(RUNNING);
+    for (unsigned i = 0; i < BATCH && loop_once(); ++i)
+    {
+        ++sequence_;
+    }
+    // Expired timers get added to the queue here.
+    long long next_timer = active_timers()->get_next_timeout();
+    if (next_timer > 0 && empty())
+    {
+        if (!active_timers()->empty())
+        {
+            // Must be done before going idle, as after that the strand may
+            // be deleted.
+            pool_->schedule_wakeup(this, os_get_time_monotonic() + next_timer);
+        }
+        uint8_t expected = RUNNING;
+        if (state_.compare_exchange_strong(expected, IDLE))
+        {
+            return;
+        }
+        if (expected == (RUNNING | DRAINING))
+        {
+            // The destructor may free the strand as soon as the semaphore is
+            // posted, so this is the last access to it.
+            OSSem *drained = drained_;
+            if (state_.compare_exchange_strong(expected, IDLE | DRAINING))
+            {
+                drained->post();
+                return;
+            }
+        }
+    }
+    // More work to do; goes to the back of the queue to let the other strands
+    // run.
+    set_state(QUEUED);
+    pool_->push(this);
+}
+
+#endif // OPENMRN_FEATURE_EXECUTOR_POOL
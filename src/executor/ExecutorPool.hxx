@@ -0,0 +1,286 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ExecutorPool.hxx
+ *
+ * A group of worker threads that run many executors (strands) with work
+ * stealing.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#ifndef _EXECUTOR_EXECUTORPOOL_HXX_
+#define _EXECUTOR_EXECUTORPOOL_HXX_
+
+#include "openmrn_features.h"
+
+#if OPENMRN_FEATURE_EXECUTOR_POOL
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "executor/Executor.hxx"
+#include "os/OS.hxx"
+
+/// A group of worker threads that share the work of many executors.
+///
+/// The executors running on the pool are called strands. A strand is a full
+/// ExecutorBase with its own queue and timers, but without a thread or select
+/// backend of its own. Whenever a strand has work, it is put into the ready queue of one of
+/// the workers; idle workers steal ready strands from the other workers. At
+/// most one worker runs a given strand at any time, so every flow bound to a
+/// strand keeps the same serialization guarantee as on a dedicated executor
+/// thread, while independent strands run in parallel on as many cores as
+/// there are workers.
+///
+/// Usage:
+///
+///   ExecutorPool pool("pool", 4);
+///   ExecutorPool::Strand train_executor(&pool);
+///   TrainService train_service(stack.iface(), &train_executor);
+///
+/// Limitations of strands compared to Executor<N>:
+/// - select() is not supported; flows waiting for file descriptors need a
+///   dedicated executor.
+/// - sync_run must not be called on a strand from the workers of the same
+///   pool, except by the strand itself.
+/// - thread priority is a property of the pool, not of the strand.
+class ExecutorPool
+{
+public:
+    class Strand;
+
+    /// Constructor. Starts the worker threads.
+    ///
+    /// @param name name of the worker threads.
+    /// @param num_workers how many threads to start.
+    /// @param priority thread priority of the workers (0 == default prio).
+    /// Unused; the hosts the pool is compiled for run the workers at default
+    /// priority.
+    /// @param stack_size stack size of the workers. Unused; the hosts the pool
+    /// is compiled for allocate the stack as needed.
+    ExecutorPool(const char *name, unsigned num_workers, int priority = 0,
+        size_t stack_size = 2048);
+
+    /// Destructor. Stops the worker threads. All strands have to be destroyed
+    /// before.
+    ~ExecutorPool();
+
+    /// @return the number of worker threads.
+    unsigned num_workers()
+    {
+        return workers_.size();
+    }
+
+    /// @return how many times a worker took a ready strand from another
+    /// worker's queue.
+    uint32_t num_steals()
+    {
+        return numSteals_.load(std::memory_order_relaxed);
+    }
+
+private:
+    class Worker;
+
+    /// How many executables a worker runs from a strand before giving the
+    /// other strands a chance.
+    static constexpr unsigned BATCH = 16;
+
+    /// Makes a strand ready to run. Called when the strand went from idle to
+    /// queued. @param s the strand.
+    void push(Strand *s);
+
+    /// Finds the next strand to run for a worker, sleeping if there is
+    /// nothing to do.
+    ///
+    /// @param w the calling worker.
+    ///
+    /// @return the strand to run, or nullptr if the pool is shutting down.
+    Strand *take(Worker *w);
+
+    /// Takes a ready strand from the back of another worker's queue.
+    /// @param w the calling worker. @return a strand or nullptr.
+    Strand *steal(Worker *w);
+
+    /// Schedules all strands whose timers expired.
+    /// @return nanoseconds until the next strand timer expires.
+    long long fire_timers();
+
+    /// Asks the pool to wake up an idle strand when its first timer expires.
+    /// @param s the strand. @param when the absolute time of the timer.
+    void schedule_wakeup(Strand *s, long long when);
+
+    /// Removes all pending wakeups of a strand. Must be called with
+    /// timerLock_ held. @param s the strand.
+    void cancel_wakeup(Strand *s);
+
+    /// The worker running on the current thread, or nullptr if the current
+    /// thread is not a pool worker.
+    static thread_local Worker *currentWorker_;
+
+    /// Worker threads.
+    std::vector<std::unique_ptr<Worker>> workers_;
+    /// Idle workers sleep on this semaphore.
+    OSSem sem_;
+    /// How many workers are sleeping or about to sleep on sem_.
+    std::atomic<unsigned> numSleeping_ {0};
+    /// Which worker gets the next strand made ready by a thread outside the
+    /// pool.
+    std::atomic<unsigned> nextWorker_ {0};
+    /// Counts the steals.
+    std::atomic<uint32_t> numSteals_ {0};
+    /// True when the pool is shutting down.
+    std::atomic<bool> exiting_ {false};
+
+    /// Protects the members below.
+    OSMutex timerLock_;
+    /// (wakeup time, strand) pairs, as a heap with the earliest at the front.
+    /// Entries that do not match the strand's wakeAt_ are stale.
+    std::vector<std::pair<long long, Strand *>> wakeups_;
+    /// Time of the earliest entry in wakeups_, or INT64_MAX. Can be read
+    /// without the lock.
+    std::atomic<long long> nextWakeup_ {INT64_MAX};
+
+    DISALLOW_COPY_AND_ASSIGN(ExecutorPool);
+};
+
+/// An executor without its own thread, whose executables are run by the
+/// workers of an ExecutorPool. Services can be bound to a strand the same way
+/// as to an Executor<N>.
+class ExecutorPool::Strand : public ExecutorBase
+{
+public:
+    /// Number of priority bands.
+    static constexpr unsigned NUM_PRIO = 4;
+
+    /// Constructor. @param pool the workers that will run this strand.
+    Strand(ExecutorPool *pool);
+
+    /// Destructor. Waits until the strand has run all queued executables and
+    /// stopped. Must not be called from the strand itself.
+    ~Strand();
+
+    /// Send a message to this Executor's queue.
+    /// @param msg Executable instance to insert into the input queue
+    /// @param priority priority of message
+    void add(Executable *msg, unsigned priority = UINT_MAX) override
+    {
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+        profile_enqueue(msg);
+#endif
+        queue_.insert(msg, priority >= NUM_PRIO ? NUM_PRIO - 1 : priority);
+        schedule();
+    }
+
+#if OPENMRN_FEATURE_RTOS_FROM_ISR
+    /// Send a message to this Executor's queue. Callable from interrupt
+    /// context.
+    /// @param msg Executable instance to insert into the input queue
+    /// @param priority priority of message
+    void add_from_isr(Executable *msg, unsigned priority = UINT_MAX) override
+    {
+        add(msg, priority);
+    }
+#endif
+
+    /// @return true if there are no executables waiting on this strand to be
+    /// executed. There could still be a current executable.
+    bool empty() override
+    {
+        return queue_.empty();
+    }
+
+    uint32_t sequence() override
+    {
+        return sequence_;
+    }
+
+private:
+    friend class ExecutorPool;
+
+    /// Scheduling state of the strand.
+    enum State : uint8_t
+    {
+        /// Nothing to do, not in any ready queue.
+        IDLE,
+        /// In the ready queue of a worker.
+        QUEUED,
+        /// A worker is running the strand.
+        RUNNING,
+        /// A worker is running the strand, and new work arrived meanwhile.
+        RUNNING_NOTIFIED,
+        /// Flag on top of the above states: the destructor is waiting for the
+        /// strand to become idle.
+        DRAINING = 0x80,
+    };
+
+    /// Changes the scheduling state, keeping the DRAINING flag. Only the
+    /// thread owning the strand (i.e. the worker that took it from a ready
+    /// queue) may call this. @param st new state.
+    void set_state(State st)
+    {
+        uint8_t s = state_.load();
+        while (!state_.compare_exchange_weak(s, st | (s & DRAINING)))
+        {
+        }
+    }
+
+    Executable *next(unsigned *priority) override
+    {
+        auto result = queue_.next();
+        *priority = result.index;
+        return static_cast<Executable *>(result.item);
+    }
+
+    /// Makes sure a worker will run this strand after an add.
+    void schedule();
+
+    /// Called by a worker: runs a batch of executables, then puts the strand
+    /// back to the ready queue or to idle.
+    void process();
+
+    /// Pool that runs this strand.
+    ExecutorPool *pool_;
+    /// Executables waiting to be run.
+    QListMpsc<NUM_PRIO> queue_;
+    /// Scheduling state, see State.
+    std::atomic<uint8_t> state_ {IDLE};
+    /// When the pool should wake up this strand for its timers, or 0 if no
+    /// wakeup is pending. Protected by the pool's timerLock_.
+    long long wakeAt_ {0};
+    /// The destructor waits on this semaphore for the strand to become idle.
+    /// Set before the DRAINING flag.
+    OSSem *drained_ {nullptr};
+
+    DISALLOW_COPY_AND_ASSIGN(Strand);
+};
+
+#endif // OPENMRN_FEATURE_EXECUTOR_POOL
+
+#endif // _EXECUTOR_EXECUTORPOOL_HXX_
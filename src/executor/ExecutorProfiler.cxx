@@ -0,0 +1,263 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ExecutorProfiler.cxx
+ *
+ * Collects run-time histograms of the executables running on an executor.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+
+#include "executor/ExecutorProfiler.hxx"
+
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+
+#include <algorithm>
+#include <cxxabi.h>
+#include <stdlib.h>
+
+/// Priority bands above this are not tracked separately.
+static constexpr unsigned MAX_BANDS = 32;
+
+void ExecutorProfiler::Histogram::add(long long nsec)
+{
+    long long us = nsec > 0 ? nsec / 1000 : 0;
+    uint32_t usec = us > UINT32_MAX ? UINT32_MAX : us;
+    unsigned bucket = usec ? 32 - __builtin_clz(usec) : 0;
+    if (bucket >= NUM_BUCKETS)
+    {
+        bucket = NUM_BUCKETS - 1;
+    }
+    ++buckets[bucket];
+    ++count;
+    totalUsec += usec;
+    if (usec > maxUsec)
+    {
+        maxUsec = usec;
+    }
+}
+
+uint32_t ExecutorProfiler::Histogram::percentile(unsigned pct) const
+{
+    if (!count)
+    {
+        return 0;
+    }
+    // Number of samples that have to be at or below the returned value.
+    uint64_t needed = ((uint64_t)count * pct + 99) / 100;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < NUM_BUCKETS - 1; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= needed)
+        {
+            return std::min(uint32_t(1) << i, maxUsec);
+        }
+    }
+    return maxUsec;
+}
+
+void ExecutorProfiler::run(Executable *msg, unsigned priority)
+{
+    long long enqueued = 0;
+    {
+        // Must be taken before running, because msg may add itself again.
+        OSMutexLock h(&lock_);
+        auto it = enqueueTime_.find(msg);
+        if (it != enqueueTime_.end())
+        {
+            enqueued = it->second;
+            enqueueTime_.erase(it);
+        }
+    }
+    // Must be taken before running, because msg may delete itself.
+    std::type_index type(typeid(*msg));
+    long long start = os_get_time_monotonic();
+    msg->run();
+    long long end = os_get_time_monotonic();
+
+    OSMutexLock h(&lock_);
+    if (enqueued && priority < MAX_BANDS)
+    {
+        if (priority >= queueWait_.size())
+        {
+            queueWait_.resize(priority + 1);
+        }
+        queueWait_[priority].add(start - enqueued);
+    }
+    Histogram &hist = runs_[type];
+    hist.add(end - start);
+    uint32_t usec = (end - start) / 1000;
+    if (!hasSlowest_ || usec >= slowestUsec_)
+    {
+        slowestType_ = type;
+        slowestUsec_ = usec;
+        hasSlowest_ = true;
+    }
+}
+
+std::vector<ExecutorProfiler::RunStats> ExecutorProfiler::run_stats()
+{
+    std::vector<std::pair<std::type_index, Histogram>> runs;
+    {
+        OSMutexLock h(&lock_);
+        runs.assign(runs_.begin(), runs_.end());
+    }
+    std::vector<RunStats> ret;
+    ret.reserve(runs.size());
+    for (auto &r : runs)
+    {
+        ret.push_back(RunStats {type_name(r.first), r.second});
+    }
+    std::sort(ret.begin(), ret.end(), [](const RunStats &a, const RunStats &b) {
+        return a.runTime.totalUsec > b.runTime.totalUsec;
+    });
+    return ret;
+}
+
+ExecutorProfiler::Histogram ExecutorProfiler::queue_wait(unsigned band)
+{
+    OSMutexLock h(&lock_);
+    if (band < queueWait_.size())
+    {
+        return queueWait_[band];
+    }
+    return Histogram();
+}
+
+unsigned ExecutorProfiler::num_bands()
+{
+    OSMutexLock h(&lock_);
+    return queueWait_.size();
+}
+
+ExecutorProfiler::Histogram ExecutorProfiler::select_wait()
+{
+    OSMutexLock h(&lock_);
+    return selectWait_;
+}
+
+uint32_t ExecutorProfiler::num_runs()
+{
+    OSMutexLock h(&lock_);
+    uint32_t ret = 0;
+    for (const auto &r : runs_)
+    {
+        ret += r.second.count;
+    }
+    return ret;
+}
+
+bool ExecutorProfiler::take_slowest(std::string *name, uint32_t *usec)
+{
+    std::type_index type(typeid(void));
+    {
+        OSMutexLock h(&lock_);
+        if (!hasSlowest_)
+        {
+            return false;
+        }
+        type = slowestType_;
+        *usec = slowestUsec_;
+        hasSlowest_ = false;
+        slowestUsec_ = 0;
+    }
+    *name = type_name(type);
+    return true;
+}
+
+void ExecutorProfiler::reset()
+{
+    {
+        OSMutexLock h(&lock_);
+        runs_.clear();
+        queueWait_.clear();
+        selectWait_ = Histogram();
+    }
+    clear_slowest();
+}
+
+/// Prints one line of histogram summary.
+///
+/// @param fp where to print
+/// @param label name of the histogram
+/// @param hist what to print
+static void print_histogram(
+    FILE *fp, const char *label, const ExecutorProfiler::Histogram &hist)
+{
+    fprintf(fp,
+        "%-18s count %8u mean %6u p50 %6u p99 %6u max %7u usec\n", label,
+        (unsigned)hist.count, (unsigned)hist.mean_usec(),
+        (unsigned)hist.percentile(50), (unsigned)hist.percentile(99),
+        (unsigned)hist.maxUsec);
+}
+
+void ExecutorProfiler::dump(FILE *fp, unsigned max_types)
+{
+    std::vector<RunStats> runs = run_stats();
+    Histogram select = select_wait();
+    std::vector<Histogram> bands;
+    {
+        OSMutexLock h(&lock_);
+        bands = queueWait_;
+    }
+    print_histogram(fp, "select wait", select);
+    for (unsigned i = 0; i < bands.size(); ++i)
+    {
+        char label[24];
+        snprintf(label, sizeof(label), "queue wait prio %u", i);
+        print_histogram(fp, label, bands[i]);
+    }
+    fprintf(fp, "run time by type, %u types:\n", (unsigned)runs.size());
+    fprintf(fp, "%10s %8s %6s %6s %6s %8s  %s\n", "total ms", "count",
+        "mean", "p50", "p99", "max usec", "type");
+    for (unsigned i = 0; i < runs.size() && i < max_types; ++i)
+    {
+        const Histogram &r = runs[i].runTime;
+        fprintf(fp, "%10.1f %8u %6u %6u %6u %8u  %s\n",
+            r.totalUsec / 1000.0, (unsigned)r.count, (unsigned)r.mean_usec(),
+            (unsigned)r.percentile(50), (unsigned)r.percentile(99),
+            (unsigned)r.maxUsec, runs[i].name.c_str());
+    }
+}
+
+std::string ExecutorProfiler::type_name(std::type_index type)
+{
+    int status = -1;
+    char *demangled =
+        abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status != 0 || !demangled)
+    {
+        return type.name();
+    }
+    std::string ret(demangled);
+    free(demangled);
+    return ret;
+}
+
+#endif // OPENMRN_FEATURE_EXECUTOR_PROFILING
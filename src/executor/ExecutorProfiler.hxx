@@ -0,0 +1,222 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ExecutorProfiler.hxx
+ *
+ * Collects run-time histograms of the executables running on an executor.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#ifndef _EXECUTOR_EXECUTORPROFILER_HXX_
+#define _EXECUTOR_EXECUTORPROFILER_HXX_
+
+#include "openmrn_features.h"
+
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+
+#include <stdio.h>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include "executor/Executable.hxx"
+#include "os/OS.hxx"
+
+/// Records how long the executables take to run on an executor, how long they
+/// waited in the queue of each priority band, and how long the executor slept
+/// in select.
+///
+/// Run times are aggregated by the dynamic type of the executable, so all the
+/// instances of a given StateFlow class share one histogram.
+///
+/// Usage:
+///
+///   ExecutorProfiler profiler;
+///   executor->set_profiler(&profiler);
+///   ...
+///   profiler.dump(stdout);
+///
+/// The executor calls enqueued(), run() and record_select_wait(); the query
+/// functions can be called from any thread. When no profiler is set, the
+/// executor pays for only a pointer check when adding and when running an
+/// executable.
+class ExecutorProfiler
+{
+public:
+    /// Number of buckets in a histogram. Bucket 0 counts the samples below 1
+    /// usec, bucket i counts the samples in [2^(i-1), 2^i) usec, the last
+    /// bucket counts everything longer.
+    static constexpr unsigned NUM_BUCKETS = 24;
+
+    /// Logarithmic histogram of durations.
+    struct Histogram
+    {
+        /// Adds a sample. @param nsec duration in nanoseconds.
+        void add(long long nsec);
+
+        /// @return an upper estimate in usec of the given percentile of the
+        /// samples (the upper end of the bucket it falls into), or zero if
+        /// there are no samples. @param pct percentile, 0..100.
+        uint32_t percentile(unsigned pct) const;
+
+        /// @return the average of the samples in usec.
+        uint32_t mean_usec() const
+        {
+            return count ? totalUsec / count : 0;
+        }
+
+        /// Number of samples.
+        uint32_t count {0};
+        /// Longest sample in usec.
+        uint32_t maxUsec {0};
+        /// Sum of all the samples in usec.
+        uint64_t totalUsec {0};
+        /// Sample count per bucket.
+        uint32_t buckets[NUM_BUCKETS] = {0};
+    };
+
+    /// Run-time statistics of one type of executable.
+    struct RunStats
+    {
+        /// Demangled name of the executable's type.
+        std::string name;
+        /// How long the run() calls took.
+        Histogram runTime;
+    };
+
+    /// Constructor.
+    ExecutorProfiler()
+    {
+    }
+
+    /// Runs an executable and records the time it took. Called by the
+    /// executor.
+    ///
+    /// @param msg executable to run.
+    /// @param priority the priority band msg was taken from.
+    void run(Executable *msg, unsigned priority);
+
+    /// Records when an executable was added to the executor queue. Called by
+    /// the executor, from any thread. @param msg the executable added.
+    void enqueued(Executable *msg)
+    {
+        long long now = os_get_time_monotonic();
+        OSMutexLock h(&lock_);
+        enqueueTime_[msg] = now;
+    }
+
+    /// Forgets the enqueue times recorded so far. Called by the executor when
+    /// the profiler is attached.
+    void clear_enqueued()
+    {
+        OSMutexLock h(&lock_);
+        enqueueTime_.clear();
+    }
+
+    /// Records the time the executor spent in a select call. Called by the
+    /// executor. @param nsec duration.
+    void record_select_wait(long long nsec)
+    {
+        OSMutexLock h(&lock_);
+        selectWait_.add(nsec);
+    }
+
+    /// @return the run-time statistics of every executable type seen, the
+    /// type with the longest total run time first.
+    std::vector<RunStats> run_stats();
+
+    /// @return the queue wait histogram of a priority band. @param band the
+    /// priority band.
+    Histogram queue_wait(unsigned band);
+
+    /// @return the number of priority bands that have seen executables.
+    unsigned num_bands();
+
+    /// @return how long the executor was sleeping in select.
+    Histogram select_wait();
+
+    /// @return total number of run() calls recorded.
+    uint32_t num_runs();
+
+    /// Retrieves the longest single run since the last call of this function,
+    /// and starts tracking the longest run anew.
+    ///
+    /// @param name will be filled in with the type name of the executable.
+    /// @param usec will be filled in with the run time.
+    ///
+    /// @return false if nothing ran since the last call.
+    bool take_slowest(std::string *name, uint32_t *usec);
+
+    /// Starts tracking the longest single run anew.
+    void clear_slowest()
+    {
+        OSMutexLock h(&lock_);
+        hasSlowest_ = false;
+        slowestUsec_ = 0;
+    }
+
+    /// Clears all the statistics.
+    void reset();
+
+    /// Prints the statistics in human-readable form.
+    ///
+    /// @param fp where to print.
+    /// @param max_types how many executable types to print at most (the ones
+    /// with the most total run time).
+    void dump(FILE *fp, unsigned max_types = 20);
+
+private:
+    /// @return demangled name of a type. @param type the type.
+    static std::string type_name(std::type_index type);
+
+    /// Protects all the members below.
+    OSMutex lock_;
+    /// Run-time histogram per executable type.
+    std::unordered_map<std::type_index, Histogram> runs_;
+    /// When the executables currently in the queue were added
+    /// (os_get_time_monotonic). Entries are removed when they run.
+    std::unordered_map<Executable *, long long> enqueueTime_;
+    /// Queue wait histogram per priority band.
+    std::vector<Histogram> queueWait_;
+    /// Select wait histogram.
+    Histogram selectWait_;
+    /// Type of the longest run since the last take_slowest call.
+    std::type_index slowestType_ {typeid(void)};
+    /// Duration of the longest run since the last take_slowest call, in usec.
+    uint32_t slowestUsec_ {0};
+    /// True if anything ran since the last take_slowest call.
+    bool hasSlowest_ {false};
+
+    DISALLOW_COPY_AND_ASSIGN(ExecutorProfiler);
+};
+
+#endif // OPENMRN_FEATURE_EXECUTOR_PROFILING
+
+#endif // _EXECUTOR_EXECUTORPROFILER_HXX_
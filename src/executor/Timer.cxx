@@ -85,32 +85,63 @@ long long ActiveTimers::get_next_timeout()
 {
     OSMutexLock l(&lock_);
 
-    QMember **last = &activeTimers_.next;
-    Timer *current_timer = static_cast<Timer *>(*last);
     long long now = OSTime::get_monotonic();
+    long long now_tick = tick_of(now);
+    if (now_tick < currentTick_)
+    {
+        // Time went backwards (this happens in unittests with a fake
+        // clock). Timers that are due are all in the current slot.
+        now_tick = currentTick_;
+    }
     bool found_timer = false;
-    while (current_timer && current_timer->when_ <= now)
+    unsigned slot;
+    while (numTimers_)
     {
-        // Deques next timer.
-        found_timer = true;
-        *last = current_timer->next;
-        current_timer->next = nullptr;
-
-        current_timer->isActive_ = 0;
-        current_timer->isExpired_ = 1;
-        // Puts it on the executor.
-        executor_->add(current_timer, current_timer->priority_);
-        // Takes the next timer.
-        current_timer = static_cast<Timer *>(*last);
+        long long tick = next_tick_locked(&slot);
+        if (tick > now_tick)
+        {
+            break;
+        }
+        if (tick > currentTick_)
+        {
+            // Nothing to do until this tick; cascades any outer slot starting
+            // here.
+            advance_locked(tick);
+            continue;
+        }
+        found_timer |= expire_locked(now);
+        if (currentTick_ == now_tick)
+        {
+            break;
+        }
+        advance_locked(currentTick_ + 1);
+    }
+    if (currentTick_ < now_tick)
+    {
+        advance_locked(now_tick);
     }
 
     if (found_timer)
     {
         return 0;
     }
-    else if (current_timer)
+    else if (numTimers_)
     {
-        long long ret = current_timer->when_ - now;
+        if (!earliest_)
+        {
+            // The earliest timer is in the first non-empty slot, because
+            // every slot covers a later time range than the ones before it.
+            next_tick_locked(&slot);
+            for (QMember *m = slots_[slot]; m; m = m->next)
+            {
+                Timer *t = static_cast<Timer *>(m);
+                if (!earliest_ || t->when_ < earliest_->when_)
+                {
+                    earliest_ = t;
+                }
+            }
+        }
+        long long ret = earliest_->when_ - now;
         return ret;
     }
     else
@@ -123,10 +154,7 @@ long long ActiveTimers::get_next_timeout()
 
 bool ActiveTimers::empty() {
     OSMutexLock l(&lock_);
-
-    QMember **last = &activeTimers_.next;
-    Timer *current_timer = static_cast<Timer *>(*last);
-    return (current_timer == nullptr);
+    return numTimers_ == 0;
 }
 
 void ActiveTimers::schedule_timer(Timer *timer)
@@ -139,17 +167,24 @@ void ActiveTimers::insert_locked(Timer *timer)
 {
     HASSERT(timer);
     HASSERT(timer->next == nullptr);
+    HASSERT(timer->prevLink_ == nullptr);
 
-    QMember **last = &activeTimers_.next;
-    Timer *current_timer = static_cast<Timer *>(*last);
-    while (current_timer && current_timer->when_ <= timer->when_)
+    if (!numTimers_)
+    {
+        // An empty wheel can jump to the current time without cascading
+        // anything. This avoids putting the timer into an outer level.
+        long long now_tick = tick_of(OSTime::get_monotonic());
+        if (now_tick > currentTick_)
+        {
+            currentTick_ = now_tick;
+        }
+    }
+    link_locked(timer);
+    ++numTimers_;
+    if (earliest_ ? timer->when_ < earliest_->when_ : numTimers_ == 1)
     {
-        last = &current_timer->next;
-        current_timer = static_cast<Timer *>(*last);
+        earliest_ = timer;
     }
-    // Inserts into the queue.
-    timer->next = current_timer;
-    *last = timer;
 
     // This will wake up the executor, which will schedule all expired timers
     // and recompute sleep length.
@@ -159,15 +194,191 @@ void ActiveTimers::insert_locked(Timer *timer)
 void ActiveTimers::remove_locked(Timer *timer)
 {
     HASSERT(timer);
-    // Removes the timer from the queue.
-    QMember **last = &activeTimers_.next;
-    while (*last && *last != timer)
+    HASSERT(timer->prevLink_ && *timer->prevLink_ == timer);
+    unlink_locked(timer);
+    --numTimers_;
+}
+
+void ActiveTimers::link_locked(Timer *timer)
+{
+    long long tick = tick_of(timer->when_);
+    if (tick < currentTick_)
+    {
+        // Already expired timers go into the current slot.
+        tick = currentTick_;
+    }
+    unsigned slot = OVERFLOW_SLOT;
+    for (unsigned level = 0; level < NUM_LEVELS; ++level)
+    {
+        unsigned shift = level * LEVEL_BITS;
+        if ((tick >> (shift + LEVEL_BITS)) ==
+            (currentTick_ >> (shift + LEVEL_BITS)))
+        {
+            slot = level * LEVEL_SIZE + ((tick >> shift) & LEVEL_MASK);
+            break;
+        }
+    }
+    // Appends to the end, so that timers with the same deadline keep their
+    // insertion order.
+    QMember **tail = tails_[slot];
+    timer->next = nullptr;
+    timer->prevLink_ = tail;
+    timer->wheelSlot_ = slot;
+    *tail = timer;
+    tails_[slot] = &timer->next;
+    if (slot < OVERFLOW_SLOT)
+    {
+        nonEmpty_[slot / LEVEL_SIZE] |= 1u << (slot % LEVEL_SIZE);
+    }
+}
+
+void ActiveTimers::unlink_locked(Timer *timer)
+{
+    unsigned slot = timer->wheelSlot_;
+    *timer->prevLink_ = timer->next;
+    if (timer->next)
+    {
+        static_cast<Timer *>(timer->next)->prevLink_ = timer->prevLink_;
+    }
+    else
+    {
+        tails_[slot] = timer->prevLink_;
+    }
+    if (!slots_[slot] && slot < OVERFLOW_SLOT)
     {
-        last = &((*last)->next);
+        nonEmpty_[slot / LEVEL_SIZE] &= ~(1u << (slot % LEVEL_SIZE));
     }
-    HASSERT(*last == timer);
-    *last = timer->next;
     timer->next = nullptr;
+    timer->prevLink_ = nullptr;
+    if (timer == earliest_)
+    {
+        earliest_ = nullptr;
+    }
+}
+
+long long ActiveTimers::next_tick_locked(unsigned *slot)
+{
+    // In the innermost level only the current and later slots may have
+    // timers.
+    unsigned idx = currentTick_ & LEVEL_MASK;
+    uint32_t bits = nonEmpty_[0] >> idx;
+    if (bits)
+    {
+        unsigned ofs = __builtin_ctz(bits);
+        *slot = idx + ofs;
+        return currentTick_ + ofs;
+    }
+    // In the outer levels the current slot was already cascaded, so only the
+    // later slots may have timers.
+    for (unsigned level = 1; level < NUM_LEVELS; ++level)
+    {
+        unsigned shift = level * LEVEL_BITS;
+        idx = (currentTick_ >> shift) & LEVEL_MASK;
+        if (idx == LEVEL_MASK)
+        {
+            continue;
+        }
+        bits = nonEmpty_[level] >> (idx + 1);
+        if (bits)
+        {
+            idx += 1 + __builtin_ctz(bits);
+            *slot = level * LEVEL_SIZE + idx;
+            long long block = currentTick_ >> (shift + LEVEL_BITS);
+            return ((block << LEVEL_BITS) + idx) << shift;
+        }
+    }
+    if (slots_[OVERFLOW_SLOT])
+    {
+        *slot = OVERFLOW_SLOT;
+        unsigned shift = NUM_LEVELS * LEVEL_BITS;
+        return ((currentTick_ >> shift) + 1) << shift;
+    }
+    return INT64_MAX;
+}
+
+void ActiveTimers::advance_locked(long long tick)
+{
+    HASSERT(tick >= currentTick_);
+    currentTick_ = tick;
+    // Cascades from the outside in, because an outer cascade may fill the
+    // current slot of the next level.
+    if ((tick & ((1LL << (NUM_LEVELS * LEVEL_BITS)) - 1)) == 0)
+    {
+        cascade_locked(OVERFLOW_SLOT);
+    }
+    for (unsigned level = NUM_LEVELS - 1; level > 0; --level)
+    {
+        unsigned shift = level * LEVEL_BITS;
+        if (tick & ((1LL << shift) - 1))
+        {
+            continue;
+        }
+        cascade_locked(level * LEVEL_SIZE + ((tick >> shift) & LEVEL_MASK));
+    }
+}
+
+void ActiveTimers::cascade_locked(unsigned slot)
+{
+    QMember *m = slots_[slot];
+    if (!m)
+    {
+        return;
+    }
+    slots_[slot] = nullptr;
+    tails_[slot] = &slots_[slot];
+    if (slot < OVERFLOW_SLOT)
+    {
+        nonEmpty_[slot / LEVEL_SIZE] &= ~(1u << (slot % LEVEL_SIZE));
+    }
+    while (m)
+    {
+        Timer *timer = static_cast<Timer *>(m);
+        m = m->next;
+        link_locked(timer);
+    }
+}
+
+bool ActiveTimers::expire_locked(long long now)
+{
+    // Collects the expired timers sorted by their deadline. The slot is in
+    // insertion order, and the sort is stable, so timers with the same
+    // deadline stay in insertion order.
+    QMember *expired = nullptr;
+    QMember *m = slots_[currentTick_ & LEVEL_MASK];
+    while (m)
+    {
+        Timer *timer = static_cast<Timer *>(m);
+        m = m->next;
+        if (timer->when_ > now)
+        {
+            continue;
+        }
+        // Dequeues timer.
+        unlink_locked(timer);
+        --numTimers_;
+        QMember **pos = &expired;
+        while (*pos && static_cast<Timer *>(*pos)->when_ <= timer->when_)
+        {
+            pos = &(*pos)->next;
+        }
+        timer->next = *pos;
+        *pos = timer;
+    }
+    if (!expired)
+    {
+        return false;
+    }
+    while (expired)
+    {
+        Timer *timer = static_cast<Timer *>(expired);
+        expired = expired->next;
+        timer->next = nullptr;
+        timer->isActive_ = 0;
+        timer->isExpired_ = 1;
+        // Puts it on the executor.
+        executor_->add(timer, timer->priority_);
+    }
+    return true;
 }
 
 void ActiveTimers::update_timer(Timer *timer)
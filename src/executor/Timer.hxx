@@ -44,7 +44,20 @@ class Timer;
 class ExecutorBase;
 
 /** Class that manages the list of active timers. The Executor uses this class
- * tightly in its sleep-execute loop. */
+ * tightly in its sleep-execute loop.
+ *
+ * The timers are kept in a hierarchical timing wheel. One tick of the wheel
+ * is 2^TICK_SHIFT nanoseconds (about one millisecond). The innermost level has
+ * one slot per tick, each further level has slots that are LEVEL_SIZE times
+ * longer than the previous level. A timer is put into the lowest level whose
+ * current block contains the timer's deadline; timers beyond the reach of the
+ * outermost level are kept in a separate overflow list. Whenever the current
+ * tick enters a new block of a level, the corresponding slot is cascaded down
+ * into the lower levels. Each slot is a doubly linked list in insertion
+ * order, thus scheduling and removing a timer is O(1). The nanosecond
+ * deadlines of the timers are retained, so timers still expire exactly at
+ * their deadline and not at the tick boundary, and timers expiring together
+ * run in the order of their deadlines. */
 class ActiveTimers : public Executable
 {
 public:
@@ -53,8 +66,17 @@ public:
     /// @param executor parent that will use this instance.
     ActiveTimers(ExecutorBase *executor)
         : executor_(executor)
+        , currentTick_(0)
+        , earliest_(nullptr)
+        , numTimers_(0)
+        , slots_ {}
+        , nonEmpty_ {}
         , isPending_(0)
     {
+        for (unsigned i = 0; i < NUM_SLOTS; ++i)
+        {
+            tails_[i] = &slots_[i];
+        }
     }
 
     ~ActiveTimers();
@@ -75,17 +97,15 @@ public:
      * scheduled. */
     void schedule_timer(::Timer *timer);
 
-    /** Updates the expiration time of an already scheduled timer. This call is
-     * somewhat expensive, because it needs to walk the entire queue of active
-     * timers. May wake up the executor.
+    /** Updates the expiration time of an already scheduled timer. This call
+     * takes constant time. May wake up the executor.
      *
      * @param timer is the timer whose next execution time has been updated. It
      * must already be scheduled. */
     void update_timer(::Timer *timer);
 
-    /** Deletes an already scheduled but not yet expired timer. This call is
-     * somewhat expensive, because it needs to walk the entire queue of active
-     * timers. Asserts that the timer is in fact not yet expired.
+    /** Deletes an already scheduled but not yet expired timer. This call
+     * takes constant time. Asserts that the timer is in fact not yet expired.
      *
      * @param timer is the timer to delete. */
     void remove_timer(::Timer *timer);
@@ -104,6 +124,28 @@ public:
     void run() override;
 
 private:
+    enum
+    {
+        /// A tick of the wheel is 2^TICK_SHIFT nanoseconds.
+        TICK_SHIFT = 20,
+        /// log2 of the number of slots in one level of the wheel.
+        LEVEL_BITS = 5,
+        /// Number of slots in one level of the wheel.
+        LEVEL_SIZE = 1 << LEVEL_BITS,
+        /// Mask for the slot index within a level.
+        LEVEL_MASK = LEVEL_SIZE - 1,
+        /// How many levels the wheel has. With the above settings the wheel
+        /// covers about 18 minutes.
+        NUM_LEVELS = 4,
+        /// Slot index of the list of timers that are beyond the reach of the
+        /// wheel.
+        OVERFLOW_SLOT = NUM_LEVELS * LEVEL_SIZE,
+        /// Total number of slots, including the overflow list.
+        NUM_SLOTS = OVERFLOW_SLOT + 1,
+    };
+
+    static_assert(NUM_SLOTS <= 256, "Timer::wheelSlot_ is too small");
+
     /** Removes a timer from the active list. Assert fails if it is not
      * there. Caller must hold the lock. 
      * @param timer what to remove from the active list. */
@@ -113,12 +155,67 @@ private:
      * @param timer what to insert into the active list. */
     void insert_locked(::Timer *timer);
 
+    /** Adds a timer to the wheel slot matching its deadline. Caller must hold
+     * the lock.
+     * @param timer what to link into the wheel. */
+    void link_locked(::Timer *timer);
+
+    /** Takes a timer out of its wheel slot. Caller must hold the lock.
+     * @param timer what to unlink from the wheel. */
+    void unlink_locked(::Timer *timer);
+
+    /** Computes the first tick at which the wheel needs attention: either a
+     * slot of the innermost level that has timers, or the beginning of a
+     * non-empty slot of an outer level which needs to be cascaded. Caller
+     * must hold the lock.
+     * @param slot will be filled with the index of the slot that the return
+     * value belongs to.
+     * @return the tick, or INT64_MAX if there are no timers. */
+    long long next_tick_locked(unsigned *slot);
+
+    /** Moves the current tick forward. Cascades the slots whose block starts
+     * at the new tick. There must be no timers between the current and the
+     * new tick. Caller must hold the lock.
+     * @param tick the new current tick. */
+    void advance_locked(long long tick);
+
+    /** Moves all timers of a slot to their place in the lower levels. Caller
+     * must hold the lock.
+     * @param slot index of the slot to cascade. */
+    void cascade_locked(unsigned slot);
+
+    /** Puts the expired timers of the current innermost slot onto the
+     * executor, in the order of their deadlines. Caller must hold the lock.
+     * @param now current time in nanoseconds.
+     * @return true if any timer was expired. */
+    bool expire_locked(long long now);
+
+    /// @return the wheel tick for a timer deadline.
+    /// @param when deadline in nanoseconds.
+    static long long tick_of(long long when)
+    {
+        return when < 0 ? 0 : (when >> TICK_SHIFT);
+    }
+
     /// Parent.
     ExecutorBase *executor_;
     /// Protects the timer list.
     OSMutex lock_;
-    /// List of timers that are scheduled.
-    QMember activeTimers_;
+    /// The tick the wheel is at. All timers with an earlier deadline are
+    /// either in the current slot of the innermost level or expired.
+    long long currentTick_;
+    /// The timer with the earliest deadline, or nullptr if not known.
+    ::Timer *earliest_;
+    /// How many timers are in the wheel.
+    unsigned numTimers_;
+    /// Heads of the lists of timers, one for each slot of each level,
+    /// followed by the overflow list.
+    QMember *slots_[NUM_SLOTS];
+    /// For each slot, the link field of the last timer in that slot, or the
+    /// slot head if the slot is empty. New timers are appended here.
+    QMember **tails_[NUM_SLOTS];
+    /// One bit for each slot per level, set if the slot is not empty.
+    uint32_t nonEmpty_[NUM_LEVELS];
     /// 1 if we in the executor's queue.
     std::atomic_uint_least8_t isPending_;
 
@@ -141,6 +238,8 @@ public:
         , priority_(UINT_MAX)
         , when_(0)
         , period_(0)
+        , prevLink_(nullptr)
+        , wheelSlot_(0)
         , isActive_(0)
         , isExpired_(0)
         , isCancelled_(0)
@@ -302,6 +401,11 @@ private:
     long long when_;
     /** period in nanoseconds for timer */
     long long period_;
+    /** Points to the link pointing to this timer in the timer wheel, or
+     * nullptr if the timer is not in the wheel. */
+    QMember **prevLink_;
+    /** Which slot of the timer wheel this timer is in. */
+    uint8_t wheelSlot_;
     /** true when the timer is in the active timers list */
     unsigned isActive_ : 1;
     /** True when the timer is in the pending executables list of the
@@ -34,6 +34,7 @@
 
 #include "openlcb/AliasAllocator.hxx"
 #include "nmranet_config.h"
+#include "openlcb/BulkAliasAllocator.hxx"
 #include "openlcb/CanDefs.hxx"
 
 namespace openlcb
@@ -44,11 +45,13 @@ size_t g_alias_test_conflicts = 0;
 AliasAllocator::AliasAllocator(NodeID if_id, IfCan *if_can)
     : StateFlow<Buffer<AliasInfo>, QList<1>>(if_can)
     , conflictHandler_(this)
+    , refillDone_(this)
     , timer_(this)
     , if_id_(if_id)
     , cid_frame_sequence_(0)
     , conflict_detected_(0)
     , reserveUnusedAliases_(config_reserve_unused_alias_count())
+    , refillPending_(0)
 {
     reinit_seed();
     // Moves all the allocated alias buffers over to the input queue for
@@ -154,6 +157,44 @@ void AliasAllocator::add_allocated_alias(NodeAlias alias)
         // This schedules a state flow onto its executor.
         w->alloc_result(nullptr);
     }
+    refill_reserved_aliases();
+}
+
+void AliasAllocator::refill_reserved_aliases()
+{
+    if (reserveUnusedAliases_ <= 1 || refillPending_)
+    {
+        return;
+    }
+    unsigned have = num_reserved_aliases();
+    unsigned waiting = waitingClients_.pending();
+    if (!waiting && have > reserveUnusedAliases_ / 2)
+    {
+        return;
+    }
+    if (have >= reserveUnusedAliases_ + waiting)
+    {
+        return;
+    }
+    // The bulk allocator reports the aliases to the interface's allocator.
+    HASSERT(if_can()->alias_allocator() == this);
+    if (!bulkAllocator_)
+    {
+        bulkAllocator_ = create_bulk_alias_allocator(if_can());
+    }
+    refillPending_ = 1;
+    auto *b = bulkAllocator_->alloc();
+    b->data()->reset(reserveUnusedAliases_ + waiting - have);
+    b->data()->done.reset(&refillDone_);
+    LOG(VERBOSE, "Refilling %u reserved aliases", b->data()->numAliases_);
+    bulkAllocator_->send(b);
+}
+
+void AliasAllocator::RefillDone::notify()
+{
+    parent_->refillPending_ = 0;
+    // More aliases might have been taken since the refill was started.
+    parent_->refill_reserved_aliases();
 }
 
 NodeAlias AliasAllocator::get_allocated_alias(
@@ -171,7 +212,11 @@ NodeAlias AliasAllocator::get_allocated_alias(
     if (found)
     {
         if_can()->local_aliases()->add(destination_id, found_alias);
-        if (reserveUnusedAliases_)
+        if (reserveUnusedAliases_ > 1)
+        {
+            refill_reserved_aliases();
+        }
+        else if (reserveUnusedAliases_)
         {
             NodeID next_id;
             NodeAlias next_alias = 0;
@@ -184,6 +229,14 @@ NodeAlias AliasAllocator::get_allocated_alias(
             }
         }
     }
+    else if (reserveUnusedAliases_ > 1)
+    {
+        // The pool is empty; the waiting client gets the first alias that
+        // the refill produces.
+        found_alias = 0;
+        waitingClients_.insert(done);
+        refill_reserved_aliases();
+    }
     else
     {
         found_alias = 0;
@@ -46,6 +46,8 @@ namespace openlcb
  * arisen during the allocation. */
 extern size_t g_alias_test_conflicts;
 
+struct BulkAliasRequest;
+
 /** Information we know locally about an NMRAnet CAN alias. */
 struct AliasInfo
 {
@@ -91,6 +93,15 @@ struct AliasInfo
  *
  * Users who need an allocated alias should get it from the queue in
  * reserved_aliases().
+ *
+ * When more than one unused alias should be kept reserved
+ * (reserve_unused_alias_count > 1), the reserved aliases form a pool that is
+ * refilled in the background by a BulkAliasAllocator. The bulk allocator
+ * sends the CID frames for many aliases back-to-back, so they all share the
+ * same 200 msec wait. A refill is started when the pool drops to half of the
+ * configured size, or when a node is waiting for an alias. The local alias
+ * cache has to be large enough to hold the pool in addition to the aliases of
+ * the local nodes, otherwise assigned aliases might get evicted.
  */
 class AliasAllocator : public StateFlow<Buffer<AliasInfo>, QList<1>>
 {
@@ -151,6 +162,11 @@ public:
      * the reserved aliases queue. */
     void return_alias(NodeID id, NodeAlias alias);
 
+    /** Starts allocating aliases in the background if the pool of reserved
+     * aliases is running low. Does nothing unless reserve_unused_alias_count
+     * is more than 1. Must be called on the interface's executor. */
+    void refill_reserved_aliases();
+
     /** Call from an alternate alias allocator. Marks that alias is reserved
      * for the local interface (RID frame is just sent out). Adds the alias to
      * the local alias cache and wakes up a flow that might be waiting for an
@@ -191,6 +207,21 @@ private:
 
     friend class ConflictHandler;
 
+    /** Gets notified when a bulk refill of the reserved aliases is done. */
+    class RefillDone : public Notifiable
+    {
+    public:
+        RefillDone(AliasAllocator *parent) : parent_(parent)
+        {
+        }
+        void notify() override;
+
+    private:
+        AliasAllocator *parent_;
+    } refillDone_;
+
+    friend class RefillDone;
+
     AliasInfo *pending_alias()
     {
         return message()->data();
@@ -233,9 +264,15 @@ private:
     /// Seed for generating random-looking alias numbers.
     unsigned seed_ : 12;
 
-    /// How many unused aliases we should reserve. Currently we only support 0
-    /// or 1 as value.
-    unsigned reserveUnusedAliases_ : 8;
+    /// How many unused aliases we should reserve. With 0 or 1 the aliases are
+    /// allocated one by one, with more a pool is kept using bulk allocation.
+    unsigned reserveUnusedAliases_ : 15;
+    /// 1 if a bulk allocation for refilling the reserved aliases is running.
+    unsigned refillPending_ : 1;
+
+    /// Allocates many aliases in parallel for refilling the reserved
+    /// aliases. Created when first needed.
+    std::unique_ptr<FlowInterface<Buffer<BulkAliasRequest>>> bulkAllocator_;
 
     /// Notifiable used for tracking outgoing frames.
     BarrierNotifiable n_;
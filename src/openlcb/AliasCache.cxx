@@ -63,15 +63,47 @@ static NodeAlias resolve_notresponding(NodeAlias stored)
 #if defined(TEST_CONSISTENCY)
 extern volatile int consistency_result;
 volatile int consistency_result = 0;
+/// Set to false to skip the consistency checks after each modification
+/// (e.g. for benchmarks).
+extern bool alias_cache_check_consistency;
+bool alias_cache_check_consistency = true;
 
 int AliasCache::check_consistency()
 {
-    if (idMap.size() != aliasMap.size())
+    std::vector<PoolIdx> alias_entries;
+    std::vector<PoolIdx> id_entries;
+    if (aliasHash_)
+    {
+        for (unsigned i = 0; i < (1u << hashBits_); ++i)
+        {
+            if (aliasHash_[i] != NONE_ENTRY)
+            {
+                alias_entries.emplace_back();
+                alias_entries.back().idx_ = aliasHash_[i];
+            }
+            if (idHash_[i] != NONE_ENTRY)
+            {
+                id_entries.emplace_back();
+                id_entries.back().idx_ = idHash_[i];
+            }
+        }
+        if (alias_entries.size() != hashCount_)
+        {
+            LOG(INFO, "hash table entry count is incorrect.");
+            return 28;
+        }
+    }
+    else
+    {
+        alias_entries.assign(aliasMap.begin(), aliasMap.end());
+        id_entries.assign(idMap.begin(), idMap.end());
+    }
+    if (id_entries.size() != alias_entries.size())
     {
         LOG(INFO, "idmap size != aliasmap size.");
         return 1;
     }
-    if (aliasMap.size() == entries)
+    if (index_size() == entries)
     {
         if (!freeList.empty())
         {
@@ -87,7 +119,7 @@ int AliasCache::check_consistency()
             return 3;
         }
     }
-    if (aliasMap.size() == 0 && (!oldest.empty() || !newest.empty()))
+    if (index_size() == 0 && (!oldest.empty() || !newest.empty()))
     {
         LOG(INFO, "LRU head/tail elements should be null when map is empty.");
         return 4;
@@ -103,12 +135,12 @@ int AliasCache::check_consistency()
         }
         free_entries.insert(m);
     }
-    if (free_entries.size() + aliasMap.size() != entries)
+    if (free_entries.size() + index_size() != entries)
     {
         LOG(INFO, "Lost some metadata entries.");
         return 6;
     }
-    for (auto kv : aliasMap)
+    for (auto kv : alias_entries)
     {
         if (free_entries.count(kv.deref(this)))
         {
@@ -116,7 +148,7 @@ int AliasCache::check_consistency()
             return 19;
         }
     }
-    for (auto kv : idMap)
+    for (auto kv : id_entries)
     {
         if (free_entries.count(kv.deref(this)))
         {
@@ -124,7 +156,7 @@ int AliasCache::check_consistency()
             return 20;
         }
     }
-    if (aliasMap.size() == 0)
+    if (index_size() == 0)
     {
         if (!oldest.empty())
         {
@@ -160,7 +192,7 @@ int AliasCache::check_consistency()
             return 12; // newest is free
         }
     }
-    if (aliasMap.size() == 0)
+    if (index_size() == 0)
     {
         return 0;
     }
@@ -194,7 +226,7 @@ int AliasCache::check_consistency()
             LOG(INFO, "Prev link points to newest.");
             return 18;
         }
-        if (count != aliasMap.size())
+        if (count != index_size())
         {
             LOG(INFO, "LRU link list length is incorrect.");
             return 27;
@@ -235,23 +267,23 @@ int AliasCache::check_consistency()
             continue;
         }
         auto *e = pool + i;
-        if (idMap.find(e->get_node_id()) == idMap.end())
+        if (find_id(e->get_node_id()).empty())
         {
             LOG(INFO, "Metadata ID is not in the id map.");
             return 23;
         }
-        if (idMap.find(e->get_node_id())->idx_ != i)
+        if (find_id(e->get_node_id()).idx_ != i)
         {
             LOG(INFO,
                 "Id map entry does not point back to the expected index.");
             return 24;
         }
-        if (aliasMap.find(e->alias_) == aliasMap.end())
+        if (find_alias(e->alias_).empty())
         {
             LOG(INFO, "Metadata alias is not in the alias map.");
             return 25;
         }
-        if (aliasMap.find(e->alias_)->idx_ != i)
+        if (find_alias(e->alias_).idx_ != i)
         {
             LOG(INFO,
                 "Alis map entry does not point back to the expected index.");
@@ -265,8 +297,17 @@ int AliasCache::check_consistency()
 
 void AliasCache::clear()
 {
+    ++generation_;
     idMap.clear();
     aliasMap.clear();
+    if (aliasHash_)
+    {
+        for (unsigned i = 0; i < (2u << hashBits_); ++i)
+        {
+            aliasHash_[i] = NONE_ENTRY;
+        }
+        hashCount_ = 0;
+    }
     oldest.idx_ = NONE_ENTRY;
     newest.idx_ = NONE_ENTRY;
     freeList.idx_ = NONE_ENTRY;
@@ -298,19 +339,20 @@ void AliasCache::add(NodeID id, NodeAlias alias)
 {
     HASSERT(id != 0);
     HASSERT(alias != 0);
+    ++generation_;
     
     Metadata *insert;
 
-    auto it = aliasMap.find(alias);
-    if (alias == NOT_RESPONDING)
+    PoolIdx it;
+    if (alias != NOT_RESPONDING)
     {
         // We can have more than one NOT_RESPONDING entry.
-        it = aliasMap.end();
+        it = find_alias(alias);
     }
-    if (it != aliasMap.end())
+    if (!it.empty())
     {
         /* we already have a mapping for this alias, so lets remove it */
-        insert = it->deref(this);
+        insert = it.deref(this);
         remove(insert->alias_);
 
         if (removeCallback)
@@ -319,11 +361,11 @@ void AliasCache::add(NodeID id, NodeAlias alias)
             (*removeCallback)(insert->get_node_id(), insert->alias_, context);
         }
     }
-    auto nit = idMap.find(id);
-    if (nit != idMap.end())
+    PoolIdx nit = find_id(id);
+    if (!nit.empty())
     {
         /* we already have a mapping for this id, so lets remove it */
-        insert = nit->deref(this);
+        insert = nit.deref(this);
         remove(insert->alias_);
 
         if (removeCallback)
@@ -344,6 +386,7 @@ void AliasCache::add(NodeID id, NodeAlias alias)
         HASSERT(!oldest.empty() && !newest.empty());
 
         /* kick out the oldest mapping and re-link the oldest endpoint */
+        index_erase(oldest);
         insert = oldest.deref(this);
         auto second = insert->newer_;
         if (!second.empty())
@@ -356,9 +399,6 @@ void AliasCache::add(NodeID id, NodeAlias alias)
         }
         oldest = second;
 
-        aliasMap.erase(aliasMap.find(insert->alias_));
-        idMap.erase(idMap.find(insert->get_node_id()));
-
         if (removeCallback)
         {
             /* tell the interface layer that we removed this mapping */
@@ -371,16 +411,14 @@ void AliasCache::add(NodeID id, NodeAlias alias)
         // This code will make all NOT_RESPONDING aliases unique in our map.
         unsigned ofs = insert - pool;
         alias = NOT_RESPONDING | ofs;
-        auto it = aliasMap.find(alias);
-        HASSERT(it == aliasMap.end());
+        HASSERT(find_alias(alias).empty());
     }
     insert->set_node_id(id);
     insert->alias_ = alias;
 
     PoolIdx n;
     n.idx_ = insert - pool;
-    aliasMap.insert(PoolIdx(n));
-    idMap.insert(PoolIdx(n));
+    index_insert(n);
 
     /* update the time based list */
     insert->newer_.idx_ = NONE_ENTRY;
@@ -401,8 +439,11 @@ void AliasCache::add(NodeID id, NodeAlias alias)
     newest = n;
 
 #if defined(TEST_CONSISTENCY)
-    consistency_result = check_consistency();
-    HASSERT(0 == consistency_result);
+    if (alias_cache_check_consistency)
+    {
+        consistency_result = check_consistency();
+        HASSERT(0 == consistency_result);
+    }
 #endif
 }
 
@@ -413,13 +454,13 @@ void AliasCache::add(NodeID id, NodeAlias alias)
  */
 void AliasCache::remove(NodeAlias alias)
 {
-    auto it = aliasMap.find(alias);
+    ++generation_;
+    PoolIdx it = find_alias(alias);
 
-    if (it != aliasMap.end())
+    if (!it.empty())
     {
-        Metadata *metadata = it->deref(this);
-        aliasMap.erase(it);
-        idMap.erase(idMap.find(metadata->get_node_id()));
+        Metadata *metadata = it.deref(this);
+        index_erase(it);
 
         if (!metadata->newer_.empty())
         {
@@ -443,8 +484,11 @@ void AliasCache::remove(NodeAlias alias)
     }
 
 #if defined(TEST_CONSISTENCY)
-    consistency_result = check_consistency();
-    HASSERT(0 == consistency_result);
+    if (alias_cache_check_consistency)
+    {
+        consistency_result = check_consistency();
+        HASSERT(0 == consistency_result);
+    }
 #endif
 }
 
@@ -469,12 +513,33 @@ bool AliasCache::retrieve(unsigned entry, NodeID* node, NodeAlias* alias)
 
 bool AliasCache::next_entry(NodeID bound, NodeID *node, NodeAlias *alias)
 {
-    auto it = idMap.upper_bound(bound);
-    if (it == idMap.end())
+    Metadata *metadata = nullptr;
+    if (aliasHash_)
     {
-        return false;
+        // The hash tables are not ordered, so we look at all entries.
+        for (PoolIdx idx = newest; !idx.empty(); idx = idx.deref(this)->older_)
+        {
+            Metadata *m = idx.deref(this);
+            if (m->get_node_id() > bound &&
+                (!metadata || m->get_node_id() < metadata->get_node_id()))
+            {
+                metadata = m;
+            }
+        }
+        if (!metadata)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        auto it = idMap.upper_bound(bound);
+        if (it == idMap.end())
+        {
+            return false;
+        }
+        metadata = it->deref(this);
     }
-    Metadata *metadata = it->deref(this);
     if (alias)
     {
         *alias = resolve_notresponding(metadata->alias_);
@@ -494,11 +559,11 @@ NodeAlias AliasCache::lookup(NodeID id)
 {
     HASSERT(id != 0);
 
-    auto it = idMap.find(id);
+    PoolIdx it = find_id(id);
 
-    if (it != idMap.end())
+    if (!it.empty())
     {
-        Metadata *metadata = it->deref(this);
+        Metadata *metadata = it.deref(this);
 
         /* update timestamp */
         touch(metadata);
@@ -520,11 +585,11 @@ NodeID AliasCache::lookup(NodeAlias alias)
         return 0;
     }
 
-    auto it = aliasMap.find(alias);
+    PoolIdx it = find_alias(alias);
 
-    if (it != aliasMap.end())
+    if (!it.empty())
     {
-        Metadata *metadata = it->deref(this);
+        Metadata *metadata = it.deref(this);
 
         /* update timestamp */
         touch(metadata);
@@ -596,9 +661,128 @@ void AliasCache::touch(Metadata* metadata)
         newest.idx_ = metadata - pool;
     }
 #if defined(TEST_CONSISTENCY)
-    consistency_result = check_consistency();
-    HASSERT(0 == consistency_result);
+    if (alias_cache_check_consistency)
+    {
+        consistency_result = check_consistency();
+        HASSERT(0 == consistency_result);
+    }
 #endif
 }
 
+AliasCache::PoolIdx AliasCache::find_alias(NodeAlias alias)
+{
+    PoolIdx ret;
+    if (aliasHash_)
+    {
+        ret.idx_ = aliasHash_[alias_slot(alias)];
+        return ret;
+    }
+    auto it = aliasMap.find(alias);
+    if (it != aliasMap.end())
+    {
+        ret = *it;
+    }
+    return ret;
+}
+
+AliasCache::PoolIdx AliasCache::find_id(NodeID id)
+{
+    PoolIdx ret;
+    if (aliasHash_)
+    {
+        ret.idx_ = idHash_[id_slot(id)];
+        return ret;
+    }
+    auto it = idMap.find(id);
+    if (it != idMap.end())
+    {
+        ret = *it;
+    }
+    return ret;
+}
+
+void AliasCache::index_insert(PoolIdx idx)
+{
+    Metadata *metadata = idx.deref(this);
+    if (aliasHash_)
+    {
+        unsigned slot = alias_slot(metadata->alias_);
+        HASSERT(aliasHash_[slot] == NONE_ENTRY);
+        aliasHash_[slot] = idx.idx_;
+        slot = id_slot(metadata->get_node_id());
+        HASSERT(idHash_[slot] == NONE_ENTRY);
+        idHash_[slot] = idx.idx_;
+        ++hashCount_;
+        return;
+    }
+    aliasMap.insert(PoolIdx(idx));
+    idMap.insert(PoolIdx(idx));
+}
+
+void AliasCache::index_erase(PoolIdx idx)
+{
+    Metadata *metadata = idx.deref(this);
+    if (aliasHash_)
+    {
+        unsigned slot = alias_slot(metadata->alias_);
+        HASSERT(aliasHash_[slot] == idx.idx_);
+        hash_erase(aliasHash_, slot);
+        slot = id_slot(metadata->get_node_id());
+        HASSERT(idHash_[slot] == idx.idx_);
+        hash_erase(idHash_, slot);
+        --hashCount_;
+        return;
+    }
+    aliasMap.erase(aliasMap.find(metadata->alias_));
+    idMap.erase(idMap.find(metadata->get_node_id()));
+}
+
+unsigned AliasCache::alias_slot(NodeAlias alias)
+{
+    const unsigned mask = (1u << hashBits_) - 1;
+    // Terminates because the table is never more than half full.
+    for (unsigned i = alias_hash(alias);; i = (i + 1) & mask)
+    {
+        uint16_t e = aliasHash_[i];
+        if (e == NONE_ENTRY || pool[e].alias_ == alias)
+        {
+            return i;
+        }
+    }
+}
+
+unsigned AliasCache::id_slot(NodeID id)
+{
+    const unsigned mask = (1u << hashBits_) - 1;
+    for (unsigned i = id_hash(id);; i = (i + 1) & mask)
+    {
+        uint16_t e = idHash_[i];
+        if (e == NONE_ENTRY || pool[e].get_node_id() == id)
+        {
+            return i;
+        }
+    }
+}
+
+void AliasCache::hash_erase(uint16_t *table, unsigned slot)
+{
+    const unsigned mask = (1u << hashBits_) - 1;
+    unsigned hole = slot;
+    for (unsigned i = (slot + 1) & mask; table[i] != NONE_ENTRY;
+         i = (i + 1) & mask)
+    {
+        Metadata *m = pool + table[i];
+        unsigned home = table == idHash_ ? id_hash(m->get_node_id())
+                                         : alias_hash(m->alias_);
+        // The entry may be moved into the hole if the hole is between its
+        // home slot and its current slot (cyclically).
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            table[hole] = table[i];
+            hole = i;
+        }
+    }
+    table[hole] = NONE_ENTRY;
+}
+
 }
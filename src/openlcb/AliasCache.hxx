@@ -82,6 +82,15 @@ namespace openlcb
  *
  * A similar sorted vector is kept sorted by the NodeID values. This also takes
  * only 2 bytes per entry.
+ *
+ * Alternatively (hash_index == true at construction) the two sorted vectors
+ * are replaced by two open-addressing hash tables, one keyed by alias and one
+ * keyed by NodeID. Each slot is a PoolIdx, and the tables are kept at most
+ * half full, using linear probing and backward-shift deletion (no
+ * tombstones). Adding and removing entries is then O(1) instead of moving
+ * vector elements around, which matters for large caches with a lot of
+ * churn. The cost is 8 to 16 bytes per entry instead of 4, and next_entry()
+ * has to scan all entries.
  */
 class AliasCache
 {
@@ -92,10 +101,12 @@ public:
      * @param remove_callback callback to call when we remove a mapping from
      *        the cache however it will not be called in the remove() method
      * @param context context pointer to pass to remove_callback
+     * @param hash_index if true, uses hash tables for the lookups instead of
+     *        sorted vectors.
      */
     AliasCache(NodeID seed, size_t _entries,
         void (*remove_callback)(NodeID id, NodeAlias alias, void *) = NULL,
-        void *context = NULL)
+        void *context = NULL, bool hash_index = false)
         : pool(new Metadata[_entries])
         , aliasMap(this)
         , idMap(this)
@@ -104,8 +115,23 @@ public:
         , removeCallback(remove_callback)
         , context(context)
     {
-        aliasMap.reserve(_entries);
-        idMap.reserve(_entries);
+        HASSERT(_entries < NONE_ENTRY);
+        if (hash_index)
+        {
+            // At most half full.
+            hashBits_ = 1;
+            while ((1u << hashBits_) < 2 * _entries)
+            {
+                ++hashBits_;
+            }
+            aliasHash_ = new uint16_t[2u << hashBits_];
+            idHash_ = aliasHash_ + (1u << hashBits_);
+        }
+        else
+        {
+            aliasMap.reserve(_entries);
+            idMap.reserve(_entries);
+        }
         clear();
     }
 
@@ -172,6 +198,14 @@ public:
      */
     bool next_entry(NodeID bound, NodeID *node, NodeAlias *alias);
 
+    /** @return a counter that changes every time a mapping is added to or
+     * removed from the cache. Lets derived indexes detect that they are
+     * stale. */
+    unsigned generation()
+    {
+        return generation_;
+    }
+
     /** Generate a 12-bit pseudo-random alias for a given alias cache.
      * @return pseudo-random 12-bit alias, an alias of zero is invalid
      */
@@ -181,6 +215,7 @@ public:
     ~AliasCache()
     {
         delete [] pool;
+        delete [] aliasHash_;
     }
 
     /** Visible for testing. Check internal consistency. */
@@ -366,11 +401,82 @@ private:
     /** context pointer to pass in with remove_callback */
     void *context;
 
+    /** Open-addressing hash table of pool indexes keyed by alias, or nullptr
+     * if the sorted maps are used. Also owns the memory of idHash_. */
+    uint16_t *aliasHash_ = nullptr;
+
+    /** Open-addressing hash table of pool indexes keyed by node ID. */
+    uint16_t *idHash_ = nullptr;
+
+    /** Each hash table has 2^hashBits_ slots. */
+    unsigned hashBits_ = 0;
+
+    /** Number of entries in the hash tables. */
+    unsigned hashCount_ = 0;
+
+    /** Incremented on every add, remove and clear. */
+    unsigned generation_ = 0;
+
     /** Update the time stamp for a given entry.
      * @param  metadata metadata associated with the entry
      */
     void touch(Metadata* metadata);
 
+    /** Finds an entry by alias.
+     * @param alias the alias to look for
+     * @return the pool index of the entry, or empty if not found
+     */
+    PoolIdx find_alias(NodeAlias alias);
+
+    /** Finds an entry by node ID.
+     * @param id the node ID to look for
+     * @return the pool index of the entry, or empty if not found
+     */
+    PoolIdx find_id(NodeID id);
+
+    /** Adds an entry to the alias and the node ID index.
+     * @param idx the entry, with the alias and node ID filled in
+     */
+    void index_insert(PoolIdx idx);
+
+    /** Removes an entry from the alias and the node ID index.
+     * @param idx the entry
+     */
+    void index_erase(PoolIdx idx);
+
+    /** @return the number of entries in the indexes. */
+    size_t index_size()
+    {
+        return aliasHash_ ? hashCount_ : aliasMap.size();
+    }
+
+    /** @return home slot of an alias in aliasHash_. @param alias key */
+    unsigned alias_hash(NodeAlias alias)
+    {
+        return (alias * 0x9E3779B1u) >> (32 - hashBits_);
+    }
+
+    /** @return home slot of a node ID in idHash_. @param id key */
+    unsigned id_hash(NodeID id)
+    {
+        return (id * 0x9E3779B97F4A7C15ull) >> (64 - hashBits_);
+    }
+
+    /** @return the slot in aliasHash_ that contains the given alias, or the
+     * empty slot where it would be inserted. @param alias key */
+    unsigned alias_slot(NodeAlias alias);
+
+    /** @return the slot in idHash_ that contains the given node ID, or the
+     * empty slot where it would be inserted. @param id key */
+    unsigned id_slot(NodeID id);
+
+    /** Clears a slot in a hash table, moving back the subsequent entries of
+     * the probe sequence to fill the gap.
+     * @param table aliasHash_ or idHash_
+     * @param slot which slot to clear
+     */
+    void hash_erase(uint16_t *table, unsigned slot);
+
     DISALLOW_COPY_AND_ASSIGN(AliasCache);
 };
 
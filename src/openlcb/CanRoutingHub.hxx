@@ -49,11 +49,15 @@ namespace openlcb
 
 /**
    A hub flow that accepts string HUB ports sending CAN frames via the
-   GridConnect protocol, performs routing decisions on the frames and sends out
-   to the appropriate ports.
-
-   TODO: need to process consumer and producer identified messages.
-   TODO: need to exclude CHECK ID frames from the source address learning.
+   GridConnect protocol as well as binary CAN frame ports, performs routing
+   decisions on the frames and sends out to the appropriate ports.
+
+   The source alias of every frame (except CHECK ID frames) is learned as
+   being reachable on the port the frame came from. Addressed messages,
+   datagrams and streams are sent only to the port of the destination when it
+   is known. Event reports are sent only to the ports on which a matching
+   consumer or consumer range was identified. Everything else is forwarded to
+   all ports.
  */
 class GcCanRoutingHub : public HubPortInterface
 {
@@ -109,6 +113,10 @@ public:
         return &deliveryFlow_;
     }
 
+    /// Adds a port that exchanges GridConnect formatted frames with the hub.
+    /// The incoming data has to be sent to this via send(), with skipMember_
+    /// set to the port.
+    /// @param port the port to add.
     void register_port(HubPortInterface *port)
     {
         OSMutexLock l(&lock_);
@@ -116,7 +124,46 @@ public:
         ports_[port].hubPort_ = port;
     }
 
+    /// Adds a port that exchanges binary CAN frames with the hub. The incoming
+    /// frames have to be sent to can_hub(), with skipMember_ set to the port.
+    /// @param port the port to add.
+    void register_port(CanHubPortInterface *port)
+    {
+        OSMutexLock l(&lock_);
+        HASSERT(port);
+        ports_[port].canPort_ = port;
+    }
+
+    /// Removes a GridConnect port. @param port the port to remove.
     void unregister_port(HubPortInterface *port)
+    {
+        unregister_port_impl(port);
+    }
+
+    /// Removes a binary CAN port. @param port the port to remove.
+    void unregister_port(CanHubPortInterface *port)
+    {
+        unregister_port_impl(port);
+    }
+
+    /// @return how many times a frame was sent out to a port.
+    size_t forwarded_count()
+    {
+        OSMutexLock l(&lock_);
+        return numForwarded_;
+    }
+
+    /// @return how many times a frame was not sent to a port, because the
+    /// routing table showed that there is no recipient for it there.
+    size_t filtered_count()
+    {
+        OSMutexLock l(&lock_);
+        return numFiltered_;
+    }
+
+private:
+    /// Marks a port as removed. @param port the port to remove.
+    void unregister_port_impl(void *port)
     {
         OSMutexLock l(&lock_);
         auto it = ports_.find(port);
@@ -129,7 +176,6 @@ public:
         pendingRemove_.push_back(port);
     }
 
-private:
     class PortParser;
     typedef std::map<void *, PortParser> PortsMap;
     /**
@@ -166,6 +212,8 @@ private:
             for (void *p : parent_->pendingRemove_)
             {
                 parent_->ports_.erase(p);
+                parent_->routingTable_.remove_port(
+                    static_cast<CanHubPortInterface *>(p));
             }
             parent_->pendingRemove_.clear();
 
@@ -187,25 +235,23 @@ private:
 
             gcBuf_ = nullptr;
 
-            if (forwardType_ == ADDRESSED && dstAddress_ != 0)
+            if (forwardType_ == ADDRESSED)
             {
-                void *port =
-                    parent_->routingTable_.lookup_port_for_address(dstAddress_);
-                nextIt_ = parent_->ports_.find(port);
-                if (nextIt_ != parent_->ports_.end())
+                dstPort_ = nullptr;
+                if (dstAddress_ != 0)
                 {
-                    // We found the desired port in the routing table.
-                    return call_immediately(STATE(forward_addressed));
+                    dstPort_ = parent_->routingTable_.lookup_port_for_address(
+                        dstAddress_);
                 }
-                else
+                auto it = parent_->ports_.find(dstPort_);
+                if (it == parent_->ports_.end() || it->second.inactive_)
                 {
+                    // Unknown destination.
                     forwardType_ = FORWARD_ALL;
                 }
             }
 
-            nextIt_ = parent_->ports_.begin();
-
-            return call_immediately(STATE(try_next_entry));
+            return call_immediately(STATE(deliver));
         }
 
         /**
@@ -234,6 +280,13 @@ private:
                     // at the reserve alias frame 200 msec later.
                     srcAddress_ = 0;
                 }
+                else if (CanDefs::get_control_field(can_id) ==
+                    CanDefs::AMR_FRAME)
+                {
+                    // The node released its alias; it may come back elsewhere.
+                    parent_->routingTable_.remove_node_id(srcAddress_);
+                    srcAddress_ = 0;
+                }
                 return;
             }
             // At this point: OpenLCB message.
@@ -312,37 +365,43 @@ private:
             forwardType_ = FORWARD_ALL;
         }
 
-        Action try_next_entry()
+        /// Sends the frame to every port that needs it, and counts the
+        /// ports that were skipped due to the routing decision.
+        Action deliver()
         {
             OSMutexLock l(&parent_->lock_);
-            if (nextIt_ == parent_->ports_.end())
-            {
-                return done_processing();
-            }
-
-            if (forwardType_ == EVENT)
+            void *src = message()->data()->skipMember_;
+            for (auto it = parent_->ports_.begin(); it != parent_->ports_.end();
+                 ++it)
             {
-                if (parent_->routingTable_.check_pcer(
-                        static_cast<CanHubPortInterface *>(nextIt_->first),
-                        event_))
+                if (it->second.inactive_ || it->first == src)
                 {
-                    forward_to_port();
+                    continue;
+                }
+                bool needed;
+                switch (forwardType_)
+                {
+                    case ADDRESSED:
+                        needed = it->first == dstPort_;
+                        break;
+                    case EVENT:
+                        needed = parent_->routingTable_.check_pcer(
+                            static_cast<CanHubPortInterface *>(it->first),
+                            event_);
+                        break;
+                    default:
+                        needed = true;
+                }
+                if (needed)
+                {
+                    forward_to_port(&it->second);
+                    ++parent_->numForwarded_;
+                }
+                else
+                {
+                    ++parent_->numFiltered_;
                 }
             }
-            else
-            {
-                // forward all
-                forward_to_port();
-            }
-
-            nextIt_++;
-            return again();
-        }
-
-        Action forward_addressed()
-        {
-            OSMutexLock l(&parent_->lock_);
-            forward_to_port();
             return done_processing();
         }
 
@@ -356,26 +415,19 @@ private:
             return release_and_exit();
         }
 
-        void forward_to_port()
+        /// Sends the current frame to a port, rendering it to GridConnect
+        /// format if needed. @param port the target port.
+        void forward_to_port(PortParser *port)
         {
-            if (nextIt_->second.inactive_)
-                return;
-            if (nextIt_->second.canPort_)
+            if (port->canPort_)
             {
-                if (nextIt_->second.canPort_ == message()->data()->skipMember_)
-                    return;
-                nextIt_->second.canPort_->send(message()->ref(), priority());
+                port->canPort_->send(message()->ref(), priority());
             }
             else
             {
-                HASSERT(nextIt_->second.hubPort_);
-                CanHubPortInterface *hpi =
-                    reinterpret_cast<CanHubPortInterface *>(
-                        nextIt_->second.hubPort_);
-                if (hpi == message()->data()->skipMember_)
-                    return;
+                HASSERT(port->hubPort_);
                 ensure_gc_buf_available();
-                nextIt_->second.hubPort_->send(gcBuf_->ref());
+                port->hubPort_->send(gcBuf_->ref());
             }
         }
 
@@ -406,7 +458,7 @@ private:
         NodeAlias srcAddress_;      //< for all OpenLCB frames
         NodeAlias dstAddress_;      //< for addressed frames
         EventId event_;             //< for PCER messages
-        PortsMap::iterator nextIt_; //< which port to consider next
+        void *dstPort_;             //< for addressed frames
         GcCanRoutingHub *parent_;
         /// Gridconnect-rendered frame.
         Buffer<HubData> *gcBuf_;
@@ -429,6 +481,10 @@ private:
     /// Keyed by the skipMember_ value of the incoming data from a given port.
     std::map<void *, PortParser> ports_;
     OSMutex lock_;
+    /// How many times a frame was sent to a port.
+    size_t numForwarded_ {0};
+    /// How many times a frame was not sent to a port due to routing.
+    size_t numFiltered_ {0};
     /** Due to race conditions involving iteration and add/remove calls, we
      * delay applying unregister requests until the next packet is being
      * sent. */
@@ -0,0 +1,201 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ConfigCache.cxx
+ * Write-back in-memory mirror of the configuration file.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#include "openlcb/ConfigCache.hxx"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "executor/Executor.hxx"
+#include "utils/FdUtils.hxx"
+#include "utils/logging.h"
+
+namespace openlcb
+{
+
+ConfigCache *ConfigCache::head_ = nullptr;
+
+ConfigCache::ConfigCache(int fd, size_t size, ExecutorBase *flush_executor)
+    : fd_(fd)
+    , size_(size)
+    , flushExecutor_(flush_executor)
+{
+    HASSERT(!find(fd));
+    struct stat statbuf;
+    ERRNOCHECK("fstat_config", fstat(fd_, &statbuf));
+    if ((size_t)statbuf.st_size < size_)
+    {
+        size_ = statbuf.st_size;
+    }
+    data_.reset(new uint8_t[size_]);
+    int ret = lseek(fd_, 0, SEEK_SET);
+    ERRNOCHECK("seek_config", ret);
+    FdUtils::repeated_read(fd_, data_.get(), size_);
+    dirtyBegin_ = size_;
+    if (flushExecutor_)
+    {
+        flushGuard_ = std::make_shared<FlushGuard>();
+        flushGuard_->cache = this;
+    }
+    next_ = head_;
+    head_ = this;
+}
+
+ConfigCache::~ConfigCache()
+{
+    if (flushGuard_)
+    {
+        // Waits for a deferred flush that is running right now, and turns the
+        // ones still queued into no-ops.
+        OSMutexLock l(&flushGuard_->lock);
+        flushGuard_->cache = nullptr;
+    }
+    flush();
+    for (ConfigCache **c = &head_; *c; c = &(*c)->next_)
+    {
+        if (*c == this)
+        {
+            *c = next_;
+            break;
+        }
+    }
+}
+
+size_t ConfigCache::read(size_t offset, void *buf, size_t len)
+{
+    if (offset >= size_)
+    {
+        return 0;
+    }
+    len = std::min(len, size_ - offset);
+    OSMutexLock l(&lock_);
+    memcpy(buf, data_.get() + offset, len);
+    return len;
+}
+
+size_t ConfigCache::write(size_t offset, const void *buf, size_t len)
+{
+    if (offset >= size_)
+    {
+        return 0;
+    }
+    len = std::min(len, size_ - offset);
+    bool schedule = false;
+    {
+        OSMutexLock l(&lock_);
+        if (!memcmp(data_.get() + offset, buf, len))
+        {
+            // Nothing changes.
+            return len;
+        }
+        memcpy(data_.get() + offset, buf, len);
+        if (offset < dirtyBegin_)
+        {
+            dirtyBegin_ = offset;
+        }
+        if (offset + len > dirtyEnd_)
+        {
+            dirtyEnd_ = offset + len;
+        }
+        if (flushExecutor_ && !flushPending_ && !batchDepth_)
+        {
+            flushPending_ = true;
+            schedule = true;
+        }
+    }
+    if (schedule)
+    {
+        std::shared_ptr<FlushGuard> guard = flushGuard_;
+        flushExecutor_->add(new CallbackExecutable([guard]() {
+            OSMutexLock l(&guard->lock);
+            if (guard->cache)
+            {
+                guard->cache->deferred_flush();
+            }
+        }));
+    }
+    return len;
+}
+
+void ConfigCache::deferred_flush()
+{
+    OSMutexLock l(&lock_);
+    flushPending_ = false;
+    if (!batchDepth_)
+    {
+        flush_locked();
+    }
+}
+
+void ConfigCache::flush()
+{
+    OSMutexLock l(&lock_);
+    flush_locked();
+}
+
+void ConfigCache::begin_batch()
+{
+    OSMutexLock l(&lock_);
+    ++batchDepth_;
+}
+
+void ConfigCache::end_batch()
+{
+    OSMutexLock l(&lock_);
+    HASSERT(batchDepth_);
+    if (!--batchDepth_)
+    {
+        flush_locked();
+    }
+}
+
+void ConfigCache::flush_locked()
+{
+    if (dirtyBegin_ >= dirtyEnd_)
+    {
+        return;
+    }
+    int ret = lseek(fd_, dirtyBegin_, SEEK_SET);
+    ERRNOCHECK("seek_config", ret);
+    FdUtils::repeated_write(
+        fd_, data_.get() + dirtyBegin_, dirtyEnd_ - dirtyBegin_);
+    dirtyBegin_ = size_;
+    dirtyEnd_ = 0;
+    ++numFlushes_;
+}
+
+} // namespace openlcb
@@ -0,0 +1,205 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file ConfigCache.hxx
+ * Write-back in-memory mirror of the configuration file.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#ifndef _OPENLCB_CONFIGCACHE_HXX_
+#define _OPENLCB_CONFIGCACHE_HXX_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "os/OS.hxx"
+#include "utils/macros.h"
+
+class ExecutorBase;
+
+namespace openlcb
+{
+
+/// Keeps a copy of the beginning of a configuration file in RAM. While the
+/// cache is alive, ConfigEntry reads and writes and the FileMemorySpace
+/// operations for the same file descriptor are served from the mirror instead
+/// of doing an lseek and a read or write syscall per field.
+///
+/// Writes are collected into a single dirty byte range, which gets written to
+/// the file by flush(). A flush is executed:
+/// - when a batch ends (see begin_batch() and end_batch()); the
+///   ConfigUpdateFlow puts every round of listener calls into a batch.
+/// - on the flush executor after the first write that made the cache dirty,
+///   unless a batch is open.
+/// - when the cache is destroyed.
+///
+/// Code that accesses the file through a different file descriptor only
+/// sees the changes after they are flushed.
+///
+/// All functions are thread-safe, except the constructor and the destructor:
+/// they may only be called while no other thread accesses the file.
+class ConfigCache
+{
+public:
+    /// Constructor. Reads the file contents into the mirror and registers
+    /// the cache for the file descriptor.
+    ///
+    /// @param fd the configuration file. Must be open for reading and writing.
+    /// @param size how many bytes from the beginning of the file to mirror.
+    /// If the file is shorter, only the existing bytes will be mirrored.
+    /// @param flush_executor if not null, the deferred flushes will run on
+    /// this executor. If null, the dirty data is only written by the explicit
+    /// or batch-end flushes.
+    ConfigCache(int fd, size_t size, ExecutorBase *flush_executor = nullptr);
+
+    /// Destructor. Flushes the dirty data and unregisters the cache. A
+    /// deferred flush that is still queued on the flush executor will do
+    /// nothing when it runs.
+    ~ConfigCache();
+
+    /// Looks up the cache for a file descriptor.
+    ///
+    /// @param fd file descriptor.
+    /// @return the cache registered for fd, or nullptr if there is none.
+    static ConfigCache *find(int fd)
+    {
+        for (ConfigCache *c = head_; c; c = c->next_)
+        {
+            if (c->fd_ == fd)
+            {
+                return c;
+            }
+        }
+        return nullptr;
+    }
+
+    /// Reads from the mirror. The range is clipped to the mirror; since the
+    /// mirror starts at the beginning of the file, the bytes served from the
+    /// mirror are always a prefix of the range.
+    ///
+    /// @param offset address in the file of the first byte to read.
+    /// @param buf where to put the data.
+    /// @param len how many bytes to read.
+    /// @return how many bytes were read from the mirror. The caller has to
+    /// read the remaining len - return value bytes from the file.
+    size_t read(size_t offset, void *buf, size_t len);
+
+    /// Writes into the mirror and marks the range dirty. The range is
+    /// clipped to the mirror like for read().
+    ///
+    /// @param offset address in the file of the first byte to write.
+    /// @param buf data to write.
+    /// @param len how many bytes to write.
+    /// @return how many bytes were written into the mirror. The caller has
+    /// to write the remaining len - return value bytes to the file.
+    size_t write(size_t offset, const void *buf, size_t len);
+
+    /// Writes the dirty range to the file.
+    void flush();
+
+    /// Holds back the deferred flushes until the matching end_batch()
+    /// call. Batches may be nested.
+    void begin_batch();
+
+    /// Ends a batch. The outermost end_batch() flushes the dirty data.
+    void end_batch();
+
+    /// @return how many bytes are mirrored.
+    size_t size()
+    {
+        return size_;
+    }
+
+    /// @return true if there is data that was not yet written to the file.
+    bool is_dirty()
+    {
+        OSMutexLock l(&lock_);
+        return dirtyBegin_ < dirtyEnd_;
+    }
+
+    /// @return how many times dirty data was written to the file.
+    unsigned num_flushes()
+    {
+        return numFlushes_;
+    }
+
+private:
+    /// Shared between the cache and the deferred flushes queued on the flush
+    /// executor. Outlives the cache if a deferred flush is still queued when
+    /// the cache is destroyed.
+    struct FlushGuard
+    {
+        /// Held while a deferred flush runs and while the cache is detached.
+        OSMutex lock;
+        /// The cache to flush, or nullptr after it was destroyed.
+        ConfigCache *cache {nullptr};
+    };
+
+    /// Writes the dirty range to the file. Caller must hold lock_.
+    void flush_locked();
+
+    /// Runs a flush scheduled on the flush executor.
+    void deferred_flush();
+
+    /// Mirrored contents of the file.
+    std::unique_ptr<uint8_t[]> data_;
+    /// Configuration file.
+    int fd_;
+    /// Number of bytes in data_.
+    size_t size_;
+    /// First byte of the dirty range.
+    size_t dirtyBegin_;
+    /// One past the last byte of the dirty range. dirtyBegin_ >= dirtyEnd_
+    /// means the mirror is clean.
+    size_t dirtyEnd_ {0};
+    /// Where to run the deferred flushes. May be null.
+    ExecutorBase *flushExecutor_;
+    /// Protects the mirror and the dirty range.
+    OSMutex lock_;
+    /// Number of open batches.
+    unsigned batchDepth_ {0};
+    /// How many times dirty data was written to the file.
+    unsigned numFlushes_ {0};
+    /// True if a deferred flush is queued on the flush executor.
+    bool flushPending_ {false};
+    /// Lets the deferred flushes find out whether the cache is still alive.
+    /// Null if there is no flush executor.
+    std::shared_ptr<FlushGuard> flushGuard_;
+    /// Next registered cache.
+    ConfigCache *next_;
+    /// Head of the list of registered caches.
+    static ConfigCache *head_;
+
+    DISALLOW_COPY_AND_ASSIGN(ConfigCache);
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_CONFIGCACHE_HXX_
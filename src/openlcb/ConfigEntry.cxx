@@ -36,6 +36,7 @@
 
 #include <sys/types.h>
 #include <unistd.h>
+#include "openlcb/ConfigCache.hxx"
 #include "utils/logging.h"
 #include "utils/FdUtils.hxx"
 
@@ -44,14 +45,40 @@ namespace openlcb
 
 void ConfigEntryBase::repeated_read(int fd, void *buf, size_t size) const
 {
-    int ret = lseek(fd, offset_, SEEK_SET);
+    size_t offset = offset_;
+    ConfigCache *cache = ConfigCache::find(fd);
+    if (cache)
+    {
+        size_t cached = cache->read(offset, buf, size);
+        if (cached == size)
+        {
+            return;
+        }
+        offset += cached;
+        buf = static_cast<uint8_t *>(buf) + cached;
+        size -= cached;
+    }
+    int ret = lseek(fd, offset, SEEK_SET);
     ERRNOCHECK("seek_config", ret);
     FdUtils::repeated_read(fd, buf, size);
 }
 
 void ConfigEntryBase::repeated_write(int fd, const void *buf, size_t size) const
 {
-    int ret = lseek(fd, offset_, SEEK_SET);
+    size_t offset = offset_;
+    ConfigCache *cache = ConfigCache::find(fd);
+    if (cache)
+    {
+        size_t cached = cache->write(offset, buf, size);
+        if (cached == size)
+        {
+            return;
+        }
+        offset += cached;
+        buf = static_cast<const uint8_t *>(buf) + cached;
+        size -= cached;
+    }
+    int ret = lseek(fd, offset, SEEK_SET);
     ERRNOCHECK("seek_config", ret);
     FdUtils::repeated_write(fd, buf, size);
 }
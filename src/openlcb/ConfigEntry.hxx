@@ -129,6 +129,7 @@ protected:
     }
 
     /// Performs a reliable read from the given FD. Crashes if the read fails.
+    /// Served from the ConfigCache if there is one for fd.
     ///
     /// @param fd the file to read data from
     /// @param buf the location to write data to
@@ -137,6 +138,8 @@ protected:
     void repeated_read(int fd, void *buf, size_t size) const;
 
     /// Performs a reliable write to the given FD. Crashes if the write fails.
+    /// If there is a ConfigCache for fd, the data is written to the file
+    /// later by the cache.
     ///
     /// @param fd the file to write data to
     /// @param buf the location of the data to write
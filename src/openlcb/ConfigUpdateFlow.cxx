@@ -56,6 +56,11 @@ void ConfigUpdateFlow::init_flow()
 
 void ConfigUpdateFlow::factory_reset()
 {
+    ConfigCache *cache = ConfigCache::find(fd_);
+    if (cache)
+    {
+        cache->begin_batch();
+    }
     for (auto it = listeners_.begin(); it != listeners_.end(); ++it) {
         it->factory_reset(fd_);
     }
@@ -64,6 +69,10 @@ void ConfigUpdateFlow::factory_reset()
     {
         it->factory_reset(fd_);
     }
+    if (cache)
+    {
+        cache->end_batch();
+    }
 }
 
 void ConfigUpdateFlow::register_update_listener(ConfigUpdateListener *listener)
@@ -72,6 +81,7 @@ void ConfigUpdateFlow::register_update_listener(ConfigUpdateListener *listener)
     pendingListeners_.push_front(listener);
     if (is_state(exit().next_state()))
     {
+        start_batch();
         start_flow(STATE(do_initial_load));
     }
 }
@@ -40,6 +40,7 @@
 #include "openmrn_features.h"
 #include "utils/ConfigUpdateListener.hxx"
 #include "utils/ConfigUpdateService.hxx"
+#include "openlcb/ConfigCache.hxx"
 #include "openlcb/NodeInitializeFlow.hxx"
 #include "executor/StateFlow.hxx"
 
@@ -113,6 +114,7 @@ public:
         needsReInit_ = 0;
         if (is_state(exit().next_state()))
         {
+            start_batch();
             start_flow(STATE(call_next_listener));
         }
     }
@@ -120,6 +122,27 @@ public:
     void register_update_listener(ConfigUpdateListener *listener) override;
     void unregister_update_listener(ConfigUpdateListener *listener) override;
 private:
+    /// Collects the config file writes of the listeners into one batch if the
+    /// config file is cached. Called when the flow starts.
+    void start_batch()
+    {
+        batchCache_ = ConfigCache::find(fd_);
+        if (batchCache_)
+        {
+            batchCache_->begin_batch();
+        }
+    }
+
+    /// Flushes the config file writes of the listeners to the file.
+    void end_batch()
+    {
+        if (batchCache_)
+        {
+            batchCache_->end_batch();
+            batchCache_ = nullptr;
+        }
+    }
+
     Action call_next_listener()
     {
         ConfigUpdateListener *l = nullptr;
@@ -184,6 +207,7 @@ private:
 
     Action apply_action()
     {
+        end_batch();
         /// TODO(balazs.racz) apply the changes reported.
         if (needsReboot_)
         {
@@ -212,6 +236,8 @@ private:
     /// did anybody request a node reinit to happen?
     unsigned needsReInit_ : 1;
     int fd_;
+    /// Config cache on which we opened a batch for the current run.
+    ConfigCache *batchCache_ {nullptr};
     BarrierNotifiable n_;
 };
 
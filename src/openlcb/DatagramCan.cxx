@@ -165,17 +165,13 @@ public:
         uint64_t buffer_key = id & (CanDefs::DST_MASK | CanDefs::SRC_MASK);
 
         dst_.alias = buffer_key >> (CanDefs::DST_SHIFT);
-        dstNode_ = nullptr;
-        dst_.id = if_can()->local_aliases()->lookup(NodeAlias(dst_.alias));
-        if (dst_.id)
-        {
-            dstNode_ = if_can()->lookup_local_node(dst_.id);
-        }
+        dstNode_ = if_can()->lookup_local_node_alias(NodeAlias(dst_.alias));
         if (!dstNode_)
         {
             // Destination not local node.
             return release_and_exit();
         }
+        dst_.id = dstNode_->node_id();
 
         DatagramPayload *buf = nullptr;
         bool last_frame = true;
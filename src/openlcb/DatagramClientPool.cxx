@@ -0,0 +1,206 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file DatagramClientPool.cxx
+ *
+ * Sends datagrams to many destinations in parallel, with at most one
+ * outstanding datagram per destination.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#include "openlcb/DatagramClientPool.hxx"
+
+namespace openlcb
+{
+
+/// Sends one datagram at a time using a client from the datagram service,
+/// then reports back to the pool.
+class DatagramClientPool::SenderFlow : public StateFlowBase
+{
+public:
+    /// Constructor. @param parent the pool owning this flow.
+    SenderFlow(DatagramClientPool *parent)
+        : StateFlowBase(parent->service_->iface())
+        , parent_(parent)
+    {
+    }
+
+    /// Starts sending a datagram.
+    /// @param b the request, ownership is transferred.
+    /// @param key the destination key of the request.
+    void start(Buffer<DatagramClientPoolRequest> *b, DstKey key)
+    {
+        request_ = b;
+        key_ = key;
+        start_flow(STATE(alloc_client));
+    }
+
+private:
+    Action alloc_client()
+    {
+        return allocate_and_call(
+            STATE(alloc_message), parent_->service_->client_allocator());
+    }
+
+    Action alloc_message()
+    {
+        client_ =
+            full_allocation_result(parent_->service_->client_allocator());
+        return allocate_and_call(parent_->service_->iface()->dispatcher(),
+            STATE(send_datagram));
+    }
+
+    Action send_datagram()
+    {
+        auto *b =
+            get_allocation_result(parent_->service_->iface()->dispatcher());
+        auto *r = request_->data();
+        b->set_done(bn_.reset(this));
+        b->data()->reset(Defs::MTI_DATAGRAM, r->src->node_id(), r->dst,
+            std::move(r->payload));
+        r->payload.clear();
+        client_->write_datagram(b);
+        return wait_and_call(STATE(datagram_done));
+    }
+
+    Action datagram_done()
+    {
+        auto *r = request_->data();
+        r->result = client_->result();
+        parent_->service_->client_allocator()->typed_insert(client_);
+        client_ = nullptr;
+        if (r->result & DatagramClient::OPERATION_SUCCESS)
+        {
+            r->resultCode = 0;
+        }
+        else
+        {
+            r->resultCode = r->result & 0xffff;
+            if (!r->resultCode)
+            {
+                r->resultCode = DatagramClient::PERMANENT_ERROR;
+            }
+        }
+        auto *b = request_;
+        request_ = nullptr;
+        // The pool may restart this flow from sender_done, and the caller may
+        // destroy the pool as soon as done is notified.
+        set_terminated();
+        parent_->sender_done(this, key_);
+        b->data()->done.notify();
+        b->unref();
+        return wait();
+    }
+
+    /// Owning pool.
+    DatagramClientPool *parent_;
+    /// Request being sent.
+    Buffer<DatagramClientPoolRequest> *request_ {nullptr};
+    /// Datagram client used for sending.
+    DatagramClient *client_ {nullptr};
+    /// Destination of the request.
+    DstKey key_;
+    /// Notified when the datagram client is done.
+    BarrierNotifiable bn_;
+};
+
+DatagramClientPool::DatagramClientPool(
+    DatagramService *service, unsigned num_senders)
+    : StateFlow<Buffer<DatagramClientPoolRequest>, QList<1>>(service->iface())
+    , service_(service)
+{
+    HASSERT(num_senders);
+    for (unsigned i = 0; i < num_senders; ++i)
+    {
+        senders_.push_back(new SenderFlow(this));
+    }
+    idle_ = senders_;
+}
+
+DatagramClientPool::~DatagramClientPool()
+{
+    HASSERT(idle_.size() == senders_.size());
+    for (auto *s : senders_)
+    {
+        delete s;
+    }
+}
+
+StateFlowBase::Action DatagramClientPool::entry()
+{
+    auto *r = message()->data();
+    service_->iface()->canonicalize_handle(&r->dst);
+    DstKey key = r->dst.id ? r->dst.id : ((UINT64_C(1) << 63) | r->dst.alias);
+    Destination &d = destinations_[key];
+    if (d.queue_.empty() && !d.busy_)
+    {
+        ready_.push_back(key);
+    }
+    d.queue_.push_back(transfer_message());
+    ++numPending_;
+    dispatch();
+    return exit();
+}
+
+void DatagramClientPool::dispatch()
+{
+    while (!ready_.empty() && !idle_.empty())
+    {
+        DstKey key = ready_.front();
+        ready_.pop_front();
+        Destination &d = destinations_[key];
+        HASSERT(!d.busy_ && !d.queue_.empty());
+        auto *b = d.queue_.front();
+        d.queue_.pop_front();
+        --numPending_;
+        d.busy_ = true;
+        SenderFlow *s = idle_.back();
+        idle_.pop_back();
+        s->start(b, key);
+    }
+}
+
+void DatagramClientPool::sender_done(SenderFlow *sender, DstKey key)
+{
+    auto it = destinations_.find(key);
+    HASSERT(it != destinations_.end());
+    it->second.busy_ = false;
+    if (it->second.queue_.empty())
+    {
+        destinations_.erase(it);
+    }
+    else
+    {
+        // Goes to the back of the line, behind the other destinations.
+        ready_.push_back(key);
+    }
+    idle_.push_back(sender);
+    dispatch();
+}
+
+} // namespace openlcb
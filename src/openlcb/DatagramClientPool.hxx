@@ -0,0 +1,161 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file DatagramClientPool.hxx
+ *
+ * Sends datagrams to many destinations in parallel, with at most one
+ * outstanding datagram per destination.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#ifndef _OPENLCB_DATAGRAMCLIENTPOOL_HXX_
+#define _OPENLCB_DATAGRAMCLIENTPOOL_HXX_
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "executor/CallableFlow.hxx"
+#include "openlcb/Datagram.hxx"
+
+namespace openlcb
+{
+
+/// Request structure for the DatagramClientPool.
+struct DatagramClientPoolRequest : public CallableFlowRequestBase
+{
+    /// Sets up a datagram to send.
+    ///
+    /// @param src local node to send the datagram from.
+    /// @param dst destination node.
+    /// @param payload datagram contents, including the datagram ID byte.
+    void reset(Node *src, NodeHandle dst, DatagramPayload payload)
+    {
+        reset_base();
+        this->src = src;
+        this->dst = dst;
+        this->payload = std::move(payload);
+        result = 0;
+    }
+
+    /// Local node sending the datagram.
+    Node *src;
+    /// Destination node.
+    NodeHandle dst;
+    /// Datagram contents. Will be empty after the datagram is sent.
+    DatagramPayload payload;
+    /// Result bits from DatagramClient::result() (including the response
+    /// flags of the Datagram OK message). resultCode is zero if the datagram
+    /// was accepted, otherwise the error code.
+    uint32_t result;
+};
+
+/// Sends datagrams to many destinations at the same time.
+///
+/// Requests are queued per destination node. Each destination has at most
+/// one datagram outstanding (waiting for Datagram OK or Rejected); many
+/// destinations are in flight in parallel, up to the number of senders given
+/// in the constructor. Destinations with queued datagrams are served in
+/// round-robin order, so a destination with a long queue does not hold up
+/// the others.
+///
+/// The datagrams are sent using the clients of the DatagramService, thus the
+/// service needs to have at least as many clients as the pool has senders to
+/// reach full parallelism.
+///
+/// Usage: allocate a buffer from the pool, fill in the request via
+/// reset(...) and set the done notifiable, then send() it to the pool. The
+/// done notifiable is called when the datagram was accepted or rejected by
+/// the destination.
+class DatagramClientPool : public StateFlow<Buffer<DatagramClientPoolRequest>,
+                               QList<1>>
+{
+public:
+    /// Constructor.
+    ///
+    /// @param service the datagram service to take the clients from.
+    /// @param num_senders how many datagrams can be outstanding at the same
+    /// time (to different destinations).
+    DatagramClientPool(DatagramService *service, unsigned num_senders);
+
+    /// Destructor. There must be no datagrams in flight.
+    ~DatagramClientPool();
+
+    /// @return the number of datagrams that are queued and not yet sent.
+    size_t pending()
+    {
+        return numPending_;
+    }
+
+private:
+    class SenderFlow;
+
+    /// Per-destination state.
+    struct Destination
+    {
+        /// Requests that are not sent yet, in arrival order.
+        std::deque<Buffer<DatagramClientPoolRequest> *> queue_;
+        /// True if a datagram to this destination is in flight.
+        bool busy_ {false};
+    };
+
+    /// Keys in the destination map. Node ID when known, otherwise the alias
+    /// with the top bit set.
+    typedef uint64_t DstKey;
+
+    /// Accepts an incoming request into the destination queues.
+    Action entry() override;
+
+    /// Starts sending datagrams while there are idle senders and destinations
+    /// with queued datagrams.
+    void dispatch();
+
+    /// Callback from a sender flow when the datagram is finished.
+    ///
+    /// @param sender the flow that is now idle.
+    /// @param key the destination to which that flow was sending.
+    void sender_done(SenderFlow *sender, DstKey key);
+
+    /// Datagram service we are sending the datagrams through.
+    DatagramService *service_;
+    /// All the sender flows we own.
+    std::vector<SenderFlow *> senders_;
+    /// Sender flows that are not sending anything now.
+    std::vector<SenderFlow *> idle_;
+    /// Destinations that have datagrams queued and none in flight. Served
+    /// from the front, re-added at the back.
+    std::deque<DstKey> ready_;
+    /// Queued datagrams and state for each destination that has any.
+    std::unordered_map<DstKey, Destination> destinations_;
+    /// Number of requests in the destination queues.
+    size_t numPending_ {0};
+};
+
+} // namespace openlcb
+
+#endif // _OPENLCB_DATAGRAMCLIENTPOOL_HXX_
@@ -35,7 +35,7 @@
 #ifndef _OPENLCB_DEFAULTNODEREGISTRY_HXX_
 #define _OPENLCB_DEFAULTNODEREGISTRY_HXX_
 
-#include <set>
+#include <unordered_set>
 
 #include "openlcb/NodeRegistry.hxx"
 
@@ -70,7 +70,9 @@ public:
     }
 
 private:
-    std::set<Node *> nodes_;
+    /// Registered nodes. Hashed, because this is checked for every incoming
+    /// traction message.
+    std::unordered_set<Node *> nodes_;
 };
 
 } // namespace openlcb
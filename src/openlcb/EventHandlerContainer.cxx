@@ -160,4 +160,191 @@ TreeEventHandlers::TreeEventHandlers()
 {
 }
 
+FlatEventHandlers::FlatEventHandlers()
+{
+}
+
+void FlatEventHandlers::register_handler(
+    const EventRegistryEntry &entry, unsigned mask)
+{
+    AtomicHolder h(this);
+    LOG(VERBOSE, "%p: register %p", this, entry.handler);
+    set_dirty();
+    pending_.emplace_back(mask, entry);
+}
+
+void FlatEventHandlers::unregister_handler(
+    EventHandler *handler, uint32_t user_arg, uint32_t user_arg_mask)
+{
+    AtomicHolder h(this);
+    set_dirty();
+    LOG(VERBOSE, "%p: unregister %p", this, handler);
+    auto matches = [handler, user_arg, user_arg_mask](
+                       const EventRegistryEntry &e) {
+        return e.handler == handler &&
+            ((e.user_arg & user_arg_mask) == (user_arg & user_arg_mask));
+    };
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                       [&matches](
+                           const std::pair<uint8_t, EventRegistryEntry> &p) {
+                           return matches(p.second);
+                       }),
+        pending_.end());
+    // Compacts the index in place, fixing up the segment boundaries.
+    uint32_t dst = 0;
+    unsigned num_segments = 0;
+    for (Segment &seg : segments_)
+    {
+        uint32_t begin = dst;
+        for (uint32_t i = seg.begin; i < seg.end; ++i)
+        {
+            if (!matches(entries_[i]))
+            {
+                entries_[dst] = entries_[i];
+                keys_[dst] = keys_[i];
+                ++dst;
+            }
+        }
+        if (dst != begin)
+        {
+            segments_[num_segments++] = {seg.mask, begin, dst};
+        }
+    }
+    entries_.erase(entries_.begin() + dst, entries_.end());
+    keys_.resize(dst);
+    segments_.resize(num_segments);
+}
+
+void FlatEventHandlers::reserve(size_t count)
+{
+    AtomicHolder h(this);
+    pending_.reserve(pending_.size() + count);
+}
+
+void FlatEventHandlers::rebuild_locked()
+{
+    if (pending_.empty())
+    {
+        return;
+    }
+    for (const Segment &seg : segments_)
+    {
+        for (uint32_t i = seg.begin; i < seg.end; ++i)
+        {
+            pending_.emplace_back(seg.mask, entries_[i]);
+        }
+    }
+    std::stable_sort(pending_.begin(), pending_.end(),
+        [](const std::pair<uint8_t, EventRegistryEntry> &a,
+            const std::pair<uint8_t, EventRegistryEntry> &b) {
+            if (a.first != b.first)
+            {
+                return a.first < b.first;
+            }
+            return a.second.event < b.second.event;
+        });
+    entries_.clear();
+    keys_.clear();
+    segments_.clear();
+    entries_.reserve(pending_.size());
+    keys_.reserve(pending_.size());
+    for (const auto &p : pending_)
+    {
+        if (segments_.empty() || segments_.back().mask != p.first)
+        {
+            segments_.push_back(
+                {p.first, (uint32_t)entries_.size(), (uint32_t)entries_.size()});
+        }
+        entries_.push_back(p.second);
+        keys_.push_back(p.second.event);
+        ++segments_.back().end;
+    }
+    pending_.clear();
+    pending_.shrink_to_fit();
+}
+
+/// Class representing the iteration state on the flat event handler
+/// registry. All matching index ranges are computed when the iteration
+/// starts.
+class FlatEventHandlers::Iterator : public EventIterator
+{
+public:
+    Iterator(FlatEventHandlers *parent)
+        : parent_(parent)
+    {
+        clear_iteration();
+    }
+
+    EventRegistryEntry *next_entry() OVERRIDE
+    {
+        while (it_ == end_)
+        {
+            if (nextRange_ >= numRanges_)
+            {
+                return nullptr;
+            }
+            it_ = ranges_[nextRange_].first;
+            end_ = ranges_[nextRange_].second;
+            ++nextRange_;
+        }
+        return it_++;
+    }
+
+    void clear_iteration() OVERRIDE
+    {
+        it_ = end_ = nullptr;
+        nextRange_ = numRanges_ = 0;
+    }
+
+    void init_iteration(EventReport *r) OVERRIDE
+    {
+        clear_iteration();
+        AtomicHolder h(parent_);
+        parent_->rebuild_locked();
+        const uint64_t *keys = parent_->keys_.data();
+        EventRegistryEntry *entries = parent_->entries_.data();
+        for (const Segment &seg : parent_->segments_)
+        {
+            uint32_t begin = seg.begin;
+            uint32_t end = seg.end;
+            // 64 bits -> all events go to everyone.
+            if (seg.mask < 64)
+            {
+                uint64_t current_mask = (1ULL << seg.mask) - 1;
+                begin = std::lower_bound(keys + seg.begin, keys + seg.end,
+                            r->event & (~current_mask)) -
+                    keys;
+                end = std::upper_bound(
+                          keys + begin, keys + seg.end, r->event + r->mask) -
+                    keys;
+            }
+            if (begin != end)
+            {
+                ranges_[numRanges_++] = {entries + begin, entries + end};
+            }
+        }
+    }
+
+private:
+    /// Maximum number of segments (mask values 0..64).
+    static constexpr unsigned MAX_RANGES = 65;
+
+    FlatEventHandlers *parent_;
+    /// Matching entries for each segment.
+    std::pair<EventRegistryEntry *, EventRegistryEntry *> ranges_[MAX_RANGES];
+    /// Number of valid entries in ranges_.
+    unsigned numRanges_;
+    /// Index in ranges_ to continue the iteration with.
+    unsigned nextRange_;
+    /// Next entry to return.
+    EventRegistryEntry *it_;
+    /// End of the current range.
+    EventRegistryEntry *end_;
+};
+
+EventIterator *FlatEventHandlers::create_iterator()
+{
+    return new Iterator(this);
+}
+
 } // namespace openlcb
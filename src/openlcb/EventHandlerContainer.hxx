@@ -187,6 +187,59 @@ private:
     MaskLookupMap handlers_;
 };
 
+/// EventRegistry implementation that keeps all event handlers in a single
+/// flat array, sorted by (mask, event). The event IDs are kept in a separate
+/// array for a cache-friendly binary search.
+///
+/// Registrations are appended to a pending list; the index is rebuilt (with
+/// one sort) at the next lookup. This makes adding thousands of handlers at
+/// startup cheap.
+///
+/// The iterator computes all matching ranges in init_iteration under the
+/// lock, after which next_entry takes no lock. This relies on the epoch
+/// check in the event service to clear iterators when the registry changes.
+class FlatEventHandlers : public EventRegistry, private Atomic
+{
+public:
+    FlatEventHandlers();
+
+    EventIterator *create_iterator() OVERRIDE;
+    void register_handler(
+        const EventRegistryEntry &entry, unsigned mask) OVERRIDE;
+    void unregister_handler(EventHandler *handler, uint32_t user_arg = 0,
+        uint32_t user_arg_mask = 0) OVERRIDE;
+    void reserve(size_t count) OVERRIDE;
+
+private:
+    class Iterator;
+    friend class Iterator;
+
+    /// All registrations with the same mask are in the index range [begin,
+    /// end).
+    struct Segment
+    {
+        /// Mask value from the registration (number of don't care bits).
+        uint8_t mask;
+        /// Index of the first entry with this mask.
+        uint32_t begin;
+        /// One past the index of the last entry with this mask.
+        uint32_t end;
+    };
+
+    /// Merges the pending registrations into the index. Must be called with
+    /// the lock held.
+    void rebuild_locked();
+
+    /// Sorted registry entries.
+    std::vector<EventRegistryEntry> entries_;
+    /// keys_[i] == entries_[i].event.
+    std::vector<uint64_t> keys_;
+    /// Non-empty segments, sorted by mask.
+    std::vector<Segment> segments_;
+    /// Registrations not yet in the index, along with their mask.
+    std::vector<std::pair<uint8_t, EventRegistryEntry>> pending_;
+};
+
 }; /* namespace openlcb */
 
 #endif  // _OPENLCB_EVENTHANDLERCONTAINER_HXX_
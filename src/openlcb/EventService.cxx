@@ -13,6 +13,7 @@
 #include "openlcb/EventHandlerContainer.hxx"
 #include "openlcb/Defs.hxx"
 #include "openlcb/EndianHelper.hxx"
+#include "nmranet_config.h"
 
 namespace openlcb
 {
@@ -59,7 +60,14 @@ EventService::Impl::Impl(EventService *service) : callerFlow_(service)
 #ifdef TARGET_LPC11Cxx
     registry.reset(new VectorEventHandlers());
 #else
-    registry.reset(new TreeEventHandlers());
+    if (config_flat_event_registry() == CONSTANT_TRUE)
+    {
+        registry.reset(new FlatEventHandlers());
+    }
+    else
+    {
+        registry.reset(new TreeEventHandlers());
+    }
 #endif
 }
 
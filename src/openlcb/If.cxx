@@ -169,6 +169,86 @@ If::If(ExecutorBase *executor, int local_nodes_count)
     , dispatcher_(this)
     , localNodes_(local_nodes_count)
 {
+    // At most half full.
+    unsigned bits = 1;
+    while ((1u << bits) < 2u * local_nodes_count)
+    {
+        ++bits;
+    }
+    node_hash_resize(bits);
+}
+
+void If::node_hash_resize(unsigned bits)
+{
+    LocalNodeSlot *old = nodeHash_;
+    unsigned old_size = old ? (1u << nodeHashBits_) : 0;
+    nodeHashBits_ = bits;
+    nodeHash_ = new LocalNodeSlot[1u << nodeHashBits_];
+    for (unsigned i = 0; i < (1u << nodeHashBits_); ++i)
+    {
+        nodeHash_[i].id = 0;
+        nodeHash_[i].node = nullptr;
+    }
+    nodeHashCount_ = 0;
+    for (unsigned i = 0; i < old_size; ++i)
+    {
+        if (old[i].node)
+        {
+            node_hash_insert(old[i].id, old[i].node);
+        }
+    }
+    delete[] old;
+}
+
+void If::node_hash_insert(NodeID id, Node *node)
+{
+    if (2 * (nodeHashCount_ + 1) > (1u << nodeHashBits_))
+    {
+        // Only happens with an unlimited local_nodes_count.
+        node_hash_resize(nodeHashBits_ + 1);
+    }
+    ++nodeHashCount_;
+    const unsigned mask = (1u << nodeHashBits_) - 1;
+    unsigned i = node_hash(id);
+    while (nodeHash_[i].node)
+    {
+        i = (i + 1) & mask;
+    }
+    nodeHash_[i].id = id;
+    nodeHash_[i].node = node;
+}
+
+void If::node_hash_erase(NodeID id)
+{
+    const unsigned mask = (1u << nodeHashBits_) - 1;
+    unsigned i = node_hash(id);
+    while (nodeHash_[i].id != id || !nodeHash_[i].node)
+    {
+        HASSERT(nodeHash_[i].node);
+        i = (i + 1) & mask;
+    }
+    --nodeHashCount_;
+    // Backward-shift deletion: moves up the following entries of the probe
+    // sequence that would not be found anymore with slot i empty.
+    unsigned j = i;
+    while (true)
+    {
+        j = (j + 1) & mask;
+        if (!nodeHash_[j].node)
+        {
+            break;
+        }
+        unsigned home = node_hash(nodeHash_[j].id);
+        // Is home cyclically in (i, j]? Then the entry stays.
+        if (((j - home) & mask) < ((j - i) & mask))
+        {
+            continue;
+        }
+        nodeHash_[i] = nodeHash_[j];
+        i = j;
+    }
+    nodeHash_[i].id = 0;
+    nodeHash_[i].node = nullptr;
 }
 
 } // namespace openlcb
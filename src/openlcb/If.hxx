@@ -194,6 +194,7 @@ public:
     /** Destructor */
     virtual ~If()
     {
+        delete[] nodeHash_;
     }
 
     /** @return Flow to send global messages to the NMRAnet bus. */
@@ -244,6 +245,7 @@ public:
         NodeID id = node->node_id();
         HASSERT(localNodes_.find(id) == localNodes_.end());
         localNodes_[id] = node;
+        node_hash_insert(id, node);
     }
 
     /** Removes a local node from this interface. This function must be called
@@ -262,12 +264,19 @@ public:
      */
     Node *lookup_local_node(NodeID id)
     {
-        auto it = localNodes_.find(id);
-        if (it == localNodes_.end())
+        const unsigned mask = (1u << nodeHashBits_) - 1;
+        for (unsigned i = node_hash(id);; i = (i + 1) & mask)
         {
-            return nullptr;
+            const LocalNodeSlot &slot = nodeHash_[i];
+            if (!slot.node)
+            {
+                return nullptr;
+            }
+            if (slot.id == id)
+            {
+                return slot.node;
+            }
         }
-        return it->second;
     }
 
     /** Looks up a node ID in the local nodes' registry. This function must be
@@ -363,6 +372,7 @@ protected:
         auto it = localNodes_.find(node->node_id());
         HASSERT(it != localNodes_.end());
         localNodes_.erase(it);
+        node_hash_erase(node->node_id());
     }
 
     /// Allocator containing the global write flows.
@@ -382,6 +392,46 @@ private:
     /// Local virtual nodes registered on this interface.
     VNodeMap localNodes_;
 
+    /// One slot of the node ID hash table.
+    struct LocalNodeSlot
+    {
+        /// Node ID of the local node.
+        NodeID id;
+        /// The local node, or nullptr if this slot is empty.
+        Node *node;
+    };
+
+    /// @return home slot of a node ID in nodeHash_. @param id key
+    unsigned node_hash(NodeID id)
+    {
+        return (id * 0x9E3779B97F4A7C15ull) >> (64 - nodeHashBits_);
+    }
+
+    /// Adds a local node to the hash table.
+    /// @param id node ID of the local node.
+    /// @param node the local node.
+    void node_hash_insert(NodeID id, Node *node);
+
+    /// Removes a local node from the hash table.
+    /// @param id node ID of the local node.
+    void node_hash_erase(NodeID id);
+
+    /// Reallocates the hash table with a given size and re-adds all entries.
+    /// @param bits the new table will have 2^bits slots.
+    void node_hash_resize(unsigned bits);
+
+    /// Open-addressing hash table of the local nodes keyed by node ID, used
+    /// for the lookups on the incoming message path. The localNodes_ map is
+    /// kept for the iteration in node ID order. Sized to be at most half full
+    /// with local_nodes_count nodes.
+    LocalNodeSlot *nodeHash_ {nullptr};
+
+    /// nodeHash_ has 2^nodeHashBits_ slots.
+    unsigned nodeHashBits_ {0};
+
+    /// Number of local nodes in nodeHash_.
+    unsigned nodeHashCount_ {0};
+
     /// Accessor for the objects and variables for supporting stream transport.
     StreamTransport *streamTransport_ {nullptr};
 
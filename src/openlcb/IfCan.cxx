@@ -34,12 +34,14 @@
 
 #include "openlcb/IfCan.hxx"
 
-#include "utils/StlMap.hxx"
+#include <deque>
+
 #include "openlcb/AliasAllocator.hxx"
 #include "openlcb/IfImpl.hxx"
 #include "openlcb/IfCanImpl.hxx"
 #include "openlcb/CanDefs.hxx"
 #include "can_frame.h"
+#include "nmranet_config.h"
 
 namespace openlcb
 {
@@ -573,7 +575,10 @@ public:
         }
         // Gets the destination address and checks if it is our node.
         dstHandle_.alias = (((unsigned)f->data[0] & 0xf) << 8) | f->data[1];
-        dstHandle_.id = if_can()->local_aliases()->lookup(dstHandle_.alias);
+        Node *dst_node = if_can()->lookup_local_node_alias(dstHandle_.alias);
+        dstHandle_.id = dst_node
+            ? dst_node->node_id()
+            : if_can()->local_aliases()->lookup(dstHandle_.alias);
         if (!dstHandle_.id) // Not destined for us.
         {
             LOG(VERBOSE, "Dropping addressed message not for local destination."
@@ -592,7 +597,8 @@ public:
             buffer_key |= CanDefs::get_mti(id_);
             /** @todo (balazs.racz): handle the error cases here, like when we
              * get a middle frame out of the blue etc. */
-            Payload *mapped_buffer = &pendingBuffers_[buffer_key];
+            PendingMessage *pending = find_pending(buffer_key);
+            Payload *mapped_buffer = &pending->data_;
             if ((f->data[0] & CanDefs::NOT_FIRST_FRAME) == 0)
             {
                 // First frame. Make sure the pending buffer is empty.
@@ -617,14 +623,15 @@ public:
             }
             else
             {
-                // Frame complete.
-                mapped_buffer->swap(buf_);
-                pendingBuffers_.erase(buffer_key);
+                // Frame complete. The reassembly buffer is released after
+                // the data was copied to the outgoing message.
+                completed_ = pending;
             }
         }
         else
         {
             // Saves the payload.
+            completed_ = nullptr;
             if (f->can_dlc > 2)
             {
                 buf_.assign((const char *)(f->data + 2), f->can_dlc - 2);
@@ -646,7 +653,21 @@ public:
         GenMessage *m = b->data();
         m->mti = static_cast<Defs::MTI>(
             (id_ & CanDefs::MTI_MASK) >> CanDefs::MTI_SHIFT);
-        m->payload.swap(buf_);
+        if (completed_)
+        {
+            // Copies instead of swapping, so that the reassembly buffer keeps
+            // its capacity for the next message, and short payloads stay in
+            // the inline storage of the message.
+            m->payload.assign(completed_->data_);
+            completed_->data_.clear();
+            completed_->key_ = UNUSED_KEY;
+            completed_ = nullptr;
+            trim_pending();
+        }
+        else
+        {
+            m->payload.swap(buf_);
+        }
         m->dst = dstHandle_;
         // This might be NULL if dst is a proxied node in a router.
         m->dstNode = if_can()->lookup_local_node(dstHandle_.id);
@@ -663,11 +684,100 @@ public:
     }
 
 private:
+    /// Key of a reassembly buffer that is not in use.
+    static constexpr uint64_t UNUSED_KEY = UINT64_MAX;
+    /// Soft limit on the number of reassembly buffers. Beyond this, a new
+    /// message reuses the buffer of a message that has not received a frame
+    /// for PENDING_TIMEOUT_NSEC (it probably lost its last frame). If there
+    /// is no such message, the list grows.
+    static constexpr unsigned MAX_PENDING = 16;
+    /// A multi-frame message with no new frame for this long may be dropped.
+    static constexpr long long PENDING_TIMEOUT_NSEC = SEC_TO_NSEC(3);
+    /// This many unused reassembly buffers are kept for reuse when no other
+    /// message is in progress.
+    static constexpr unsigned KEPT_PENDING = 2;
+
+    /// Reassembly buffer for a multi-frame message.
+    struct PendingMessage
+    {
+        /// dst alias, src alias and MTI of the message being assembled.
+        uint64_t key_;
+        /// os_get_time_monotonic() when the last frame was added.
+        long long lastFrameTime_;
+        /// Payload received so far.
+        Payload data_;
+    };
+
+    /// Finds the reassembly buffer for a message, or takes an unused one.
+    /// @param key dst alias, src alias and MTI of the message.
+    /// @return reassembly buffer.
+    PendingMessage *find_pending(uint64_t key)
+    {
+        long long now = os_get_time_monotonic();
+        PendingMessage *unused = nullptr;
+        PendingMessage *oldest = nullptr;
+        for (auto &p : pendingBuffers_)
+        {
+            if (p.key_ == key)
+            {
+                p.lastFrameTime_ = now;
+                return &p;
+            }
+            if (p.key_ == UNUSED_KEY)
+            {
+                if (!unused)
+                {
+                    unused = &p;
+                }
+            }
+            else if (!oldest || p.lastFrameTime_ < oldest->lastFrameTime_)
+            {
+                oldest = &p;
+            }
+        }
+        if (!unused)
+        {
+            if (pendingBuffers_.size() >= MAX_PENDING &&
+                now - oldest->lastFrameTime_ > PENDING_TIMEOUT_NSEC)
+            {
+                LOG(WARNING, "Dropping incomplete multi-frame message with "
+                             "key %" PRIx64 ", no frame for %u msec.",
+                    oldest->key_,
+                    (unsigned)NSEC_TO_MSEC(now - oldest->lastFrameTime_));
+                unused = oldest;
+                unused->data_.clear();
+            }
+            else
+            {
+                pendingBuffers_.emplace_back();
+                unused = &pendingBuffers_.back();
+            }
+        }
+        unused->key_ = key;
+        unused->lastFrameTime_ = now;
+        return unused;
+    }
+
+    /// Releases the unused reassembly buffers from the end of the list,
+    /// keeping a few of them for reuse.
+    void trim_pending()
+    {
+        while (pendingBuffers_.size() > KEPT_PENDING &&
+            pendingBuffers_.back().key_ == UNUSED_KEY)
+        {
+            pendingBuffers_.pop_back();
+        }
+    }
+
     uint32_t id_;
     string buf_;
     NodeHandle dstHandle_;
-    /// Reassembly buffers for multi-frame messages.
-    StlMap<uint32_t, Payload> pendingBuffers_;
+    /// Reassembly buffers for multi-frame messages. Entries are reused
+    /// (along with their allocated capacity) after the message is complete.
+    std::deque<PendingMessage> pendingBuffers_;
+    /// Reassembly buffer holding the payload of the message being sent to
+    /// the dispatcher, or nullptr if the payload is in buf_.
+    PendingMessage *completed_ {nullptr};
 };
 
 IfCan::IfCan(ExecutorBase *executor, CanHubFlow *device,
@@ -676,8 +786,15 @@ IfCan::IfCan(ExecutorBase *executor, CanHubFlow *device,
     : If(executor, local_nodes_count)
     , CanIf(this, device)
     , localAliases_(0, local_alias_cache_size)
-    , remoteAliases_(0, remote_alias_cache_size)
+    , remoteAliases_(0, remote_alias_cache_size, nullptr, nullptr,
+          config_remote_alias_cache_hash_index() == CONSTANT_TRUE)
 {
+    if (config_local_node_alias_index() == CONSTANT_TRUE)
+    {
+        aliasNodes_.reset(new Node *[NUM_ALIASES]);
+        std::fill(aliasNodes_.get(), aliasNodes_.get() + NUM_ALIASES, nullptr);
+        aliasNodesGeneration_ = localAliases_.generation();
+    }
     auto *gflow = new GlobalCanMessageWriteFlow(this);
     globalWriteFlow_ = gflow;
     add_owned_flow(gflow);
@@ -756,6 +873,7 @@ void IfCan::add_addressed_message_support()
 
 void IfCan::delete_local_node(Node *node) {
     remove_local_node_from_map(node);
+    clear_alias_index();
     auto alias = localAliases_.lookup(node->node_id());
     if (alias) {
         // The node had a local alias.
@@ -811,11 +929,55 @@ Node *IfCan::lookup_local_node_handle(NodeHandle h)
 {
     if (!h.id)
     {
-        h.id = local_aliases()->lookup(h.alias);
+        return lookup_local_node_alias(h.alias);
     }
     return lookup_local_node(h.id);
 }
 
+Node *IfCan::lookup_local_node_alias(NodeAlias alias)
+{
+    if (!alias)
+    {
+        return nullptr;
+    }
+    if (!aliasNodes_)
+    {
+        NodeID id = local_aliases()->lookup(alias);
+        return id ? lookup_local_node(id) : nullptr;
+    }
+    if (localAliases_.generation() != aliasNodesGeneration_)
+    {
+        clear_alias_index();
+    }
+    Node *n = aliasNodes_[alias];
+    if (n)
+    {
+        return n;
+    }
+    NodeID id = local_aliases()->lookup(alias);
+    n = id ? lookup_local_node(id) : nullptr;
+    if (n)
+    {
+        aliasNodes_[alias] = n;
+        aliasNodesFilled_.push_back(alias);
+    }
+    return n;
+}
+
+void IfCan::clear_alias_index()
+{
+    if (!aliasNodes_)
+    {
+        return;
+    }
+    for (NodeAlias a : aliasNodesFilled_)
+    {
+        aliasNodes_[a] = nullptr;
+    }
+    aliasNodesFilled_.clear();
+    aliasNodesGeneration_ = localAliases_.generation();
+}
+
 NodeID IfCan::get_default_node_id()
 {
     if (!aliasAllocator_)
@@ -132,11 +132,22 @@ public:
 
     Node *lookup_local_node_handle(NodeHandle handle) override;
 
+    /** Looks up a local node by its alias. This function must be called from
+     * the interface's executor.
+     *
+     * @param alias is the alias of the destination.
+     * @returns the node pointer or NULL if the alias does not belong to a
+     * local node registered on this interface. */
+    Node *lookup_local_node_alias(NodeAlias alias);
+
     NodeID get_default_node_id() override;
 
 private:
     void canonicalize_handle(NodeHandle *h) override;
 
+    /// Empties the alias-indexed local node table.
+    void clear_alias_index();
+
     friend class CanFrameWriteFlow; // accesses the device and the hubport.
 
     /** Aliases we know are owned by local (virtual or proxied) nodes.
@@ -156,6 +167,21 @@ private:
     /// Owns the alias allocator module.
     std::unique_ptr<AliasAllocator> aliasAllocator_;
 
+    /// Aliases are 12 bits.
+    static constexpr unsigned NUM_ALIASES = 1u << 12;
+
+    /// Local nodes indexed by their alias, or nullptr if the alias index is
+    /// not enabled (see local_node_alias_index). Filled in lazily upon
+    /// lookup, and emptied when localAliases_ or the set of local nodes
+    /// changes.
+    std::unique_ptr<Node *[]> aliasNodes_;
+
+    /// Aliases that have an entry in aliasNodes_.
+    std::vector<NodeAlias> aliasNodesFilled_;
+
+    /// Generation of localAliases_ that aliasNodes_ is valid for.
+    unsigned aliasNodesGeneration_ {0};
+
     DISALLOW_COPY_AND_ASSIGN(IfCan);
 };
 
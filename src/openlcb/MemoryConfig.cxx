@@ -46,6 +46,7 @@
 #include "can_ioctl.h"
 #endif
 
+#include "openlcb/ConfigCache.hxx"
 #include "openlcb/ConfigUpdateFlow.hxx"
 
 extern "C" {
@@ -151,18 +152,33 @@ size_t FileMemorySpace::write(address_t destination, const uint8_t *data,
         *error = Defs::ERROR_PERMANENT;
         return 0;
     }
+    size_t cached = 0;
+    ConfigCache *cache = ConfigCache::find(fd_);
+    if (cache)
+    {
+        // The part of the range in the mirror is written there, the rest goes
+        // to the file.
+        cached = cache->write(destination, data, len);
+        if (cached == len)
+        {
+            return len;
+        }
+        destination += cached;
+        data += cached;
+        len -= cached;
+    }
     off_t actual_position = lseek(fd_, destination, SEEK_SET);
     if ((address_t)actual_position != destination)
     {
         *error = MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
-        return 0;
+        return cached;
     }
     ssize_t ret = ::write(fd_, data, len);
     if (ret < 0)
     {
         LOG(INFO, "Error writing to fd %d: %s", fd_, strerror(errno));
         *error = Defs::ERROR_PERMANENT;
-        return 0;
+        return cached;
     }
     else if ((size_t)ret < len)
     {
@@ -170,11 +186,11 @@ size_t FileMemorySpace::write(address_t destination, const uint8_t *data,
         *error = ERROR_AGAIN;
         HASSERT(ioctl(fd_, CAN_IOC_WRITE_ACTIVE, again) == 0);
 #endif
-        return ret;
+        return cached + ret;
     }
     else
     {
-        return ret;
+        return cached + ret;
     }
 }
 
@@ -187,12 +203,6 @@ size_t FileMemorySpace::read(address_t destination, uint8_t *dst, size_t len,
         *error = Defs::ERROR_PERMANENT;
         return 0;
     }
-    off_t actual_position = lseek(fd_, destination, SEEK_SET);
-    if ((address_t)actual_position != destination)
-    {
-        *error = Defs::ERROR_PERMANENT;
-        return 0;
-    }
     if (destination >= fileSize_)
     {
         *error = MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
@@ -202,12 +212,31 @@ size_t FileMemorySpace::read(address_t destination, uint8_t *dst, size_t len,
     {
         len = fileSize_ - destination;
     }
+    size_t cached = 0;
+    ConfigCache *cache = ConfigCache::find(fd_);
+    if (cache)
+    {
+        cached = cache->read(destination, dst, len);
+        if (cached == len)
+        {
+            return len;
+        }
+        destination += cached;
+        dst += cached;
+        len -= cached;
+    }
+    off_t actual_position = lseek(fd_, destination, SEEK_SET);
+    if ((address_t)actual_position != destination)
+    {
+        *error = Defs::ERROR_PERMANENT;
+        return cached;
+    }
     ssize_t ret = ::read(fd_, dst, len);
     if (ret < 0)
     {
         LOG(INFO, "Error reading from fd %d: %s", fd_, strerror(errno));
         *error = Defs::ERROR_PERMANENT;
-        return 0;
+        return cached;
     }
     else if ((size_t)ret < len)
     {
@@ -215,11 +244,11 @@ size_t FileMemorySpace::read(address_t destination, uint8_t *dst, size_t len,
         *error = ERROR_AGAIN;
         HASSERT(ioctl(fd_, CAN_IOC_READ_ACTIVE, again) == 0);
 #endif
-        return ret;
+        return cached + ret;
     }
     else
     {
-        return ret;
+        return cached + ret;
     }
 }
 
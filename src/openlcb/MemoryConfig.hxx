@@ -800,9 +800,14 @@ private:
         response_.push_back(available_commands >> 8);
         response_.push_back(available_commands & 0xff);
         // Write lengths
-        response_.push_back(static_cast<char> (
-            MemoryConfigDefs::LENGTH_1 | MemoryConfigDefs::LENGTH_2 |
-            MemoryConfigDefs::LENGTH_4 | MemoryConfigDefs::LENGTH_ARBITRARY));
+        uint8_t write_lengths = MemoryConfigDefs::LENGTH_1 |
+            MemoryConfigDefs::LENGTH_2 | MemoryConfigDefs::LENGTH_4 |
+            MemoryConfigDefs::LENGTH_ARBITRARY;
+        if (streamHandler_)
+        {
+            write_lengths |= MemoryConfigDefs::LENGTH_STREAM;
+        }
+        response_.push_back(static_cast<char>(write_lengths));
 
         uint8_t min_space = 0xFF;
         uint8_t max_space = 0;
@@ -40,6 +40,7 @@
 #include "openlcb/IfCan.hxx"
 #include "openlcb/MemoryConfig.hxx"
 #include "openlcb/StreamReceiver.hxx"
+#include "openlcb/StreamSender.hxx"
 #include "openlcb/StreamTransport.hxx"
 
 namespace openlcb
@@ -72,6 +73,11 @@ struct MemoryConfigClientRequest : public CallableFlowRequestBase
         WRITE
     };
 
+    enum WriteStreamCmd
+    {
+        WRITE_STREAM
+    };
+
     enum UpdateCompleteCmd
     {
         UPDATE_COMPLETE
@@ -180,6 +186,21 @@ struct MemoryConfigClientRequest : public CallableFlowRequestBase
         payload = std::move(data);
     }
 
+    /// Sets up a command to write a part of a memory space using stream
+    /// transport.
+    /// @param WriteStreamCmd polymorphic matching arg; always set to
+    /// WRITE_STREAM.
+    /// @param d is the destination node to write to
+    /// @param space is the memory space to write to
+    /// @param offset if the address of the first byte to write
+    /// @param data is the data to write
+    void reset(WriteStreamCmd, NodeHandle d, uint8_t space, unsigned offset,
+        string data)
+    {
+        reset(WRITE, d, space, offset, std::move(data));
+        use_stream = true;
+    }
+
     /// Sets up a command to send an Update Complete request to a remote node.
     /// @param UpdateCompleteCmd polymorphic matching arg; always set to
     /// UPDATE_COMPLETE.
@@ -603,6 +624,7 @@ private:
         return return_with_error(error);
     }
 
+protected:
     void cleanup_write()
     {
         responsePayload_.clear();
@@ -617,6 +639,7 @@ private:
         return return_ok();
     }
 
+private:
     Action do_meta_request()
     {
         dgClient_ = full_allocation_result(dg_service()->client_allocator());
@@ -782,6 +805,21 @@ private:
                         parent_->timer_.trigger();
                     }
                     return respond_ok(0);
+                case MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY:
+                case MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED:
+                    if (parent_->request()->cmd !=
+                            MemoryConfigClientRequest::CMD_WRITE ||
+                        !parent_->request()->use_stream)
+                    {
+                        break;
+                    }
+                    parent_->responseCode_ = 0;
+                    message()->data()->payload.swap(parent_->responsePayload_);
+                    if (parent_->isWaitingForTimer_)
+                    {
+                        parent_->timer_.trigger();
+                    }
+                    return respond_ok(0);
             }
             return respond_reject(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
         }
@@ -832,13 +870,10 @@ public:
         Node *node, MemoryConfigHandler *memcfg, uint8_t local_stream_id)
         : MemoryConfigClient(node, memcfg)
     {
-        /// @todo make this not specific to the CAN-buf interface but somehow
-        /// portable.
-        IfCan *iface = static_cast<IfCan *>(node_->iface());
-        HASSERT(iface);
-        HASSERT(iface->stream_transport());
-        dstStreamId_ = iface->stream_transport()->get_next_stream_receive_id();
-        receiver_.reset(new StreamReceiverCan(iface, dstStreamId_));
+        StreamTransport *transport = node_->iface()->stream_transport();
+        HASSERT(transport);
+        dstStreamId_ = transport->get_next_stream_receive_id();
+        receiver_.reset(transport->create_receiver(dstStreamId_));
     }
 
 protected:
@@ -855,6 +890,9 @@ protected:
             case MemoryConfigClientRequest::CMD_READ_PART:
                 return allocate_and_call(
                     STATE(do_stream_read), dg_service()->client_allocator());
+            case MemoryConfigClientRequest::CMD_WRITE:
+                return allocate_and_call(
+                    STATE(do_stream_write), dg_service()->client_allocator());
             default:
                 return return_with_error(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
         }
@@ -992,6 +1030,163 @@ protected:
         return return_with_error(request()->resultCode);
     }
 
+    Action do_stream_write()
+    {
+        dgClient_ = full_allocation_result(dg_service()->client_allocator());
+        memoryConfigHandler_->set_client(&responseFlow_);
+        return allocate_and_call(STATE(got_stream_sender),
+            node_->iface()->stream_transport()->sender_allocator());
+    }
+
+    Action got_stream_sender()
+    {
+        StreamTransport *transport = node_->iface()->stream_transport();
+        sender_ = full_allocation_result(transport->sender_allocator());
+        srcStreamId_ = transport->get_send_stream_id();
+        return allocate_and_call(dg_service()->iface()->dispatcher(),
+            STATE(send_stream_write_datagram));
+    }
+
+    Action send_stream_write_datagram()
+    {
+        auto *b = get_allocation_result(dg_service()->iface()->dispatcher());
+        b->set_done(bn_.reset(this));
+        b->data()->reset(Defs::MTI_DATAGRAM, node_->node_id(), request()->dst,
+            MemoryConfigDefs::write_stream_datagram(
+                request()->memory_space, request()->address, srcStreamId_));
+
+        isWaitingForTimer_ = 0;
+        responseCode_ = DatagramClient::OPERATION_PENDING;
+        dgClient_->write_datagram(b);
+        return wait_and_call(STATE(stream_write_dg_complete));
+    }
+
+    Action stream_write_dg_complete()
+    {
+        if (!(dgClient_->result() & DatagramClient::OPERATION_SUCCESS))
+        {
+            // some error occurred.
+            return handle_write_stream_error(dgClient_->result());
+        }
+        // The remote node accepted the command, so it is waiting for our
+        // stream.
+        sender_->start_stream(node_, request()->dst, srcStreamId_);
+        return call_immediately(STATE(wait_for_write_started));
+    }
+
+    Action wait_for_write_started()
+    {
+        auto state = sender_->get_state();
+        if (state == StreamSender::RUNNING)
+        {
+            // The payload is sent directly from the request without copying.
+            auto *b = sender_->alloc();
+            b->data()->set_from(&request()->payload);
+            sender_->send(b);
+            sender_->close_stream();
+            return call_immediately(STATE(wait_for_write_closed));
+        }
+        if (state == StreamSender::STATE_ERROR)
+        {
+            LOG(INFO, "failed to start stream: 0x%04x", sender_->get_error());
+            return handle_write_stream_error(sender_->get_error());
+        }
+        sender_->notify_on_state_change(this);
+        return wait();
+    }
+
+    Action wait_for_write_closed()
+    {
+        auto state = sender_->get_state();
+        if (state == StreamSender::STATE_ERROR && sender_->is_waiting())
+        {
+            return handle_write_stream_error(sender_->get_error());
+        }
+        if (state != StreamSender::CLOSING || !sender_->is_waiting())
+        {
+            sender_->notify_on_state_change(this);
+            return wait();
+        }
+        // All data is sent. Waits for the remote node to write it. The reply
+        // only comes after the whole stream is written, so the timeout grows
+        // with the stream length.
+        if (responseCode_ & DatagramClient::OPERATION_PENDING)
+        {
+            isWaitingForTimer_ = 1;
+            long long kbytes = (request()->payload.size() + 1023) / 1024;
+            long long timeout_nsec = SEC_TO_NSEC(3) +
+                kbytes * MSEC_TO_NSEC(config_stream_write_reply_msec_per_kb());
+            return sleep_and_call(
+                &timer_, timeout_nsec, STATE(stream_write_response));
+        }
+        return call_immediately(STATE(stream_write_response));
+    }
+
+    Action stream_write_response()
+    {
+        if (responseCode_ & DatagramClient::OPERATION_PENDING)
+        {
+            return handle_write_stream_error(Defs::OPENMRN_TIMEOUT);
+        }
+        size_t len = responsePayload_.size();
+        const uint8_t *bytes =
+            MemoryConfigDefs::payload_bytes(responsePayload_);
+        if (!MemoryConfigDefs::payload_min_length_check(responsePayload_, 2))
+        {
+            LOG(INFO,
+                "Memory Config client: response datagram payload not "
+                "long enough");
+            return handle_write_stream_error(
+                Defs::ERROR_INVALID_ARGS_MESSAGE_TOO_SHORT);
+        }
+        unsigned ofs = MemoryConfigDefs::get_payload_offset(responsePayload_);
+        unsigned address = MemoryConfigDefs::get_address(responsePayload_);
+        uint8_t space = MemoryConfigDefs::get_space(responsePayload_);
+        uint8_t cmd = bytes[1] & MemoryConfigDefs::COMMAND_MASK;
+        if (address != request()->address ||
+            space != request()->memory_space)
+        {
+            return handle_write_stream_error(Defs::ERROR_OUT_OF_ORDER);
+        }
+        if (cmd == MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED)
+        {
+            if (len < ofs + 2)
+            {
+                return handle_write_stream_error(
+                    Defs::ERROR_INVALID_ARGS_MESSAGE_TOO_SHORT);
+            }
+            uint16_t error = bytes[ofs++];
+            error <<= 8;
+            error |= bytes[ofs];
+            return handle_write_stream_error(error);
+        }
+        if (cmd != MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY)
+        {
+            return handle_write_stream_error(Defs::ERROR_UNIMPLEMENTED);
+        }
+        cleanup_stream_write();
+        return return_ok();
+    }
+
+    /// Called upon errors of the stream write. The stream sender must not be
+    /// in the middle of sending a stream.
+    Action handle_write_stream_error(int error)
+    {
+        cleanup_stream_write();
+        return return_with_error(error);
+    }
+
+    /// Returns the stream sender and the datagram client.
+    void cleanup_stream_write()
+    {
+        StreamTransport *transport = node_->iface()->stream_transport();
+        sender_->clear();
+        transport->sender_allocator()->typed_insert(sender_);
+        sender_ = nullptr;
+        transport->release_send_stream_id(srcStreamId_);
+        cleanup_write();
+    }
+
     /// Stores incoming stream data into the request()->payload object
     /// (which is a string).
     struct DefaultSink : public ByteSink
@@ -1019,6 +1214,11 @@ protected:
     uint8_t dstStreamId_;
     /// Holds a ref to the stream receiver request.
     BufferPtr<StreamReceiveRequest> streamRecvRequest_;
+    /// Stream sender used for writes. Allocated from the stream transport
+    /// only while a write is pending.
+    StreamSender *sender_ {nullptr};
+    /// stream ID on the local device for the write stream.
+    uint8_t srcStreamId_;
 }; // class MemoryConfigClientWithStream
 
 } // namespace openlcb
@@ -231,6 +231,31 @@ struct MemoryConfigDefs
         p.push_back(0xff & (length));
         return p;
     }
+
+    static DatagramPayload write_stream_datagram(uint8_t space,
+        uint32_t offset, uint8_t src_stream_id,
+        uint8_t dst_stream_id = 0xFF)
+    {
+        DatagramPayload p;
+        p.reserve(9);
+        p.push_back(DatagramDefs::CONFIGURATION);
+        p.push_back(COMMAND_WRITE_STREAM);
+        p.push_back(0xff & (offset >> 24));
+        p.push_back(0xff & (offset >> 16));
+        p.push_back(0xff & (offset >> 8));
+        p.push_back(0xff & (offset));
+        if (is_special_space(space))
+        {
+            p[1] |= space & ~SPACE_SPECIAL;
+        }
+        else
+        {
+            p.push_back(space);
+        }
+        p.push_back(src_stream_id); // src ID
+        p.push_back(dst_stream_id); // dst ID
+        return p;
+    }
     
     /// @return true if the payload has minimum number of bytes you need in a
     /// read or write datagram message to cover for the necessary fields
@@ -35,8 +35,10 @@
 #ifndef _OPENLCB_MEMORYCONFIGSTREAM_HXX_
 #define _OPENLCB_MEMORYCONFIGSTREAM_HXX_
 
+#include "nmranet_config.h"
 #include "openlcb/If.hxx"
 #include "openlcb/MemoryConfig.hxx"
+#include "openlcb/StreamReceiverInterface.hxx"
 #include "openlcb/StreamSender.hxx"
 #include "openlcb/StreamTransport.hxx"
 
@@ -102,10 +104,7 @@ private:
         LOG(INFO, "got sender");
         sender_ =
             full_allocation_result(stream_transport()->sender_allocator());
-        /// @todo the APIs are not on the right object in StreamSender, so we
-        /// have to do this down cast.
-        senderCan_ = static_cast<StreamSenderCan *>(sender_);
-        HASSERT(senderCan_);
+        HASSERT(sender_);
         return call_immediately(STATE(initiate_stream));
     }
 
@@ -113,28 +112,28 @@ private:
     {
         LOG(INFO, "initiate");
         srcStreamId_ = stream_transport()->get_send_stream_id();
-        senderCan_->start_stream(node_, dst_, srcStreamId_, dstStreamId_);
+        sender_->start_stream(node_, dst_, srcStreamId_, dstStreamId_);
         return call_immediately(STATE(wait_for_started));
     }
 
     Action wait_for_started()
     {
-        auto state = senderCan_->get_state();
+        auto state = sender_->get_state();
         if (state == StreamSender::RUNNING)
         {
-            dstStreamId_ = senderCan_->get_dst_stream_id();
+            dstStreamId_ = sender_->get_dst_stream_id();
             startedCb_(0);
             return call_immediately(STATE(alloc_buffer));
         }
         if (state == StreamSender::STATE_ERROR)
         {
-            auto err = senderCan_->get_error();
+            auto err = sender_->get_error();
             LOG(INFO, "failed to start stream: 0x%04x", err);
             startedCb_(err);
             return call_immediately(STATE(done_stream));
         }
-        return sleep_and_call(
-            &timer_, MSEC_TO_NSEC(3), STATE(wait_for_started));
+        sender_->notify_on_state_change(this);
+        return wait();
     }
 
     Action alloc_buffer()
@@ -158,7 +157,7 @@ private:
         if (!len_)
         {
             sender_->send(sendBuffer_.release());
-            senderCan_->close_stream();
+            sender_->close_stream();
             return call_immediately(STATE(wait_for_close));
         }
         size_t free = sendBuffer_->data()->free_space();
@@ -185,7 +184,7 @@ private:
         if (err == MemoryConfigDefs::ERROR_OUT_OF_BOUNDS)
         {
             sender_->send(sendBuffer_.release());
-            senderCan_->close_stream();
+            sender_->close_stream();
             return call_immediately(STATE(wait_for_close));
         }
         if (!err)
@@ -196,32 +195,33 @@ private:
         {
             LOG(INFO, "error reading input stream: %04x", err);
             sender_->send(sendBuffer_.release());
-            senderCan_->close_stream(err);
+            sender_->close_stream(err);
             return call_immediately(STATE(wait_for_close));
         }
     }
 
     Action wait_for_close()
     {
-        auto state = senderCan_->get_state();
-        if (state == StreamSender::CLOSING && senderCan_->is_waiting())
+        auto state = sender_->get_state();
+        if (state == StreamSender::CLOSING && sender_->is_waiting())
         {
             // Sender is done and empty.
             return call_immediately(STATE(done_stream));
         }
-        if (state == StreamSender::STATE_ERROR && senderCan_->is_waiting())
+        if (state == StreamSender::STATE_ERROR && sender_->is_waiting())
         {
             // Sender has errored and consumed / thrown away all data.
             // There is no place really to show the error.
-            LOG(INFO, "Stream sender error: 0x%04x", senderCan_->get_error());
+            LOG(INFO, "Stream sender error: 0x%04x", sender_->get_error());
             return call_immediately(STATE(done_stream));
         }
-        return sleep_and_call(&timer_, MSEC_TO_NSEC(3), STATE(wait_for_close));
+        sender_->notify_on_state_change(this);
+        return wait();
     }
 
     Action done_stream()
     {
-        senderCan_->clear();
+        sender_->clear();
         stream_transport()->sender_allocator()->typed_insert(sender_);
         sender_ = nullptr;
         return delete_this();
@@ -239,8 +239,6 @@ private:
     LimitedPool sendBufferPool_ {sizeof(RawBuffer), 2, rawBufferPool};
     /// We keep reading into this buffer from the memory space.
     ByteBufferPtr sendBuffer_;
-    /// Helper object for waiting.
-    StateFlowTimer timer_ {this};
     /// Address to which we are sending the stream.
     NodeHandle dst_;
     /// callback to invoke after start is successful.
@@ -258,14 +256,224 @@ private:
     /// How many bytes are left to read. 0xFFFFFFFF if all bytes until EOF need
     /// to be read.
     uint32_t len_;
+    /// Stream sender we got from the stream transport.
+    StreamSender *sender_;
+};
+
+/// Receives a stream and writes the incoming data into a memory space. This
+/// is the data sink of a stream receiver. The receiver only hands out the next
+/// stream window when the buffers of the earlier windows are released, so a
+/// slow memory space throttles the stream sender. The flow is owned by the
+/// MemoryConfigStreamHandler and reused for every write stream.
+class MemorySpaceStreamWriteFlow : public StateFlow<ByteBuffer, QList<1>>
+{
+public:
+    /// Constructor.
     ///
+    /// @param iface the interface on which the streams arrive. Must have a
+    /// stream transport.
+    MemorySpaceStreamWriteFlow(If *iface)
+        : StateFlow<ByteBuffer, QList<1>>(iface)
+        , receiver_(iface->stream_transport()->create_receiver(
+              iface->stream_transport()->get_next_stream_receive_id()))
+        , streamDone_(0)
+    { }
+
+    /// Starts receiving a stream into a memory space. Must not be called
+    /// while a write is in progress.
     ///
-    StreamSenderCan *senderCan_;
-    StreamSender *sender_;
+    /// @param node local virtual node receiving the stream.
+    /// @param space memory space to write into.
+    /// @param src remote node sending the stream.
+    /// @param src_stream_id stream ID on the remote node.
+    /// @param ofs address of the first byte to write.
+    /// @param done will be notified when the stream is closed and all data is
+    /// written.
+    void start(Node *node, MemorySpace *space, NodeHandle src,
+        uint8_t src_stream_id, uint32_t ofs, Notifiable *done)
+    {
+        HASSERT(!done_);
+        space_ = space;
+        ofs_ = ofs;
+        error_ = 0;
+        streamDone_ = 0;
+        lastNumChunks_ = numChunks_;
+        done_ = done;
+        receiver_->pool()->alloc(&recvRequest_);
+        recvRequest_->data()->reset(this, node, src, src_stream_id);
+        recvRequest_->data()->done.reset(&recvDone_);
+        receiver_->send(recvRequest_->ref());
+    }
+
+    /// @return true if a write stream is in progress.
+    bool is_busy()
+    {
+        return done_ != nullptr;
+    }
+
+    /// Checks whether the write made progress since the previous call.
+    ///
+    /// @return true if stream data was written into the memory space since
+    /// the previous call of this function or start().
+    bool take_progress()
+    {
+        bool ret = numChunks_ != lastNumChunks_;
+        lastNumChunks_ = numChunks_;
+        return ret;
+    }
+
+    /// Gives up on the current write. Releases the stream receiver, throws
+    /// away the data still queued, then notifies done with the given error.
+    /// Must be called on the interface's executor while a write is in
+    /// progress.
+    ///
+    /// @param error OpenLCB error code to report.
+    void cancel(uint16_t error)
+    {
+        if (!error_)
+        {
+            error_ = error;
+        }
+        if (recvRequest_->data()->resultCode &
+            StreamReceiveRequest::OPERATION_PENDING)
+        {
+            receiver_->cancel_request();
+        }
+    }
+
+    /// @return the local (destination) stream ID.
+    uint8_t get_dst_stream_id()
+    {
+        return recvRequest_->data()->localStreamId_;
+    }
+
+    /// @return the remote (source) stream ID.
+    uint8_t get_src_stream_id()
+    {
+        return recvRequest_->data()->srcStreamId_;
+    }
+
+    /// @return 0 if the stream was received and written successfully,
+    /// otherwise an OpenLCB error code. Valid after done was notified.
+    uint16_t get_error()
+    {
+        return error_;
+    }
+
+    /// Start of state machine, called for each chunk of stream data.
+    Action entry() override
+    {
+        if (!message()->data()->size())
+        {
+            if (streamDone_ && queue_empty())
+            {
+                // This is the marker sent after the receiver is done.
+                return call_immediately(STATE(stream_done));
+            }
+            return release_and_exit();
+        }
+        if (error_)
+        {
+            // Throws away the rest of the stream.
+            return release_and_exit();
+        }
+        ++numChunks_;
+        MemorySpace::errorcode_t err = 0;
+        size_t written = space_->write(ofs_, message()->data()->data_,
+            message()->data()->size(), &err, this);
+        message()->data()->advance(written);
+        ofs_ += written;
+        if (err == MemorySpace::ERROR_AGAIN)
+        {
+            return wait();
+        }
+        if (err)
+        {
+            LOG(INFO, "error writing stream to memory space: %04x", err);
+            error_ = err;
+            return release_and_exit();
+        }
+        if (message()->data()->size())
+        {
+            if (!written)
+            {
+                // The space took no data and reported no error.
+                error_ = MemoryConfigDefs::ERROR_OUT_OF_BOUNDS;
+                return release_and_exit();
+            }
+            return again();
+        }
+        return release_and_exit();
+    }
+
+private:
+    /// Called when the receiver is done, the stream is closed and all data
+    /// chunks are in our queue.
+    void receive_done()
+    {
+        streamDone_ = 1;
+        // Empty marker that gets queued after all the data chunks.
+        this->send(alloc());
+    }
+
+    /// All data is written.
+    Action stream_done()
+    {
+        if (!error_ && recvRequest_->data()->resultCode)
+        {
+            error_ = recvRequest_->data()->resultCode;
+        }
+        Notifiable *d = done_;
+        done_ = nullptr;
+        d->notify();
+        return release_and_exit();
+    }
+
+    /// Notifiable for the stream receive request.
+    class ReceiveDone : public Notifiable
+    {
+    public:
+        ReceiveDone(MemorySpaceStreamWriteFlow *parent)
+            : parent_(parent)
+        { }
+
+        void notify() override
+        {
+            parent_->receive_done();
+        }
+
+    private:
+        MemorySpaceStreamWriteFlow *parent_;
+    } recvDone_ {this};
+
+    /// Receives the stream data from the interface.
+    std::unique_ptr<StreamReceiverInterface> receiver_;
+    /// Request to the stream receiver.
+    BufferPtr<StreamReceiveRequest> recvRequest_;
+    /// Memory space we are writing.
+    MemorySpace *space_ {nullptr};
+    /// Notified when the write is complete. nullptr when idle.
+    Notifiable *done_ {nullptr};
+    /// Next byte to write.
+    uint32_t ofs_ {0};
+    /// Error code from writing the memory space or receiving the stream.
+    uint16_t error_ {0};
+    /// Incremented for every attempt to write data into the memory space.
+    unsigned numChunks_ {0};
+    /// Value of numChunks_ at the last take_progress() call.
+    unsigned lastNumChunks_ {0};
+    /// 1 when the stream receiver is done.
+    uint8_t streamDone_ : 1;
 };
 
 /// Handler for the stream read/write commands in the memory config protocol
 /// (server side).
+///
+/// A write stream keeps this handler busy until the whole stream is written
+/// and the Write Stream Reply is sent. Stream read and write commands arriving
+/// in the meantime (from any node) queue up behind it. Other memory config
+/// commands are not affected, because MemoryConfigHandler only forwards the
+/// stream commands here.
 class MemoryConfigStreamHandler : public MemoryConfigHandlerBase
 {
 public:
@@ -291,7 +499,10 @@ public:
             {
                 return call_immediately(STATE(handle_read_stream));
             }
-                /// @todo handle write stream
+            case MemoryConfigDefs::COMMAND_WRITE_STREAM:
+            {
+                return call_immediately(STATE(handle_write_stream));
+            }
         }
         return respond_reject(Defs::ERROR_UNIMPLEMENTED_SUBCMD);
     }
@@ -386,6 +597,94 @@ private:
         return respond_ok(DatagramClient::REPLY_PENDING);
     }
 
+    Action handle_write_stream()
+    {
+        size_t len = message()->data()->payload.size();
+        const uint8_t *bytes = in_bytes();
+
+        MemorySpace *space = get_space();
+        if (!space)
+        {
+            return respond_reject(MemoryConfigDefs::ERROR_SPACE_NOT_KNOWN);
+        }
+        if (space->read_only())
+        {
+            return respond_reject(MemoryConfigDefs::ERROR_WRITE_TO_RO);
+        }
+        size_t stream_data_offset = 6;
+        if (has_custom_space())
+        {
+            ++stream_data_offset;
+        }
+        if (len < stream_data_offset + 1)
+        {
+            return respond_reject(Defs::ERROR_INVALID_ARGS);
+        }
+        if (!writeFlow_)
+        {
+            writeFlow_.reset(new MemorySpaceStreamWriteFlow(
+                message()->data()->dst->iface()));
+        }
+        writeFlow_->start(message()->data()->dst, space,
+            message()->data()->src, bytes[stream_data_offset], get_address(),
+            &writeDone_);
+        // The source node starts the stream after the datagram OK arrives.
+        inline_respond_ok(DatagramClient::REPLY_PENDING);
+        return sleep_and_call(&timer_,
+            MSEC_TO_NSEC(config_stream_write_timeout_msec()),
+            STATE(write_wait));
+    }
+
+    /// Called when the write flow is done, or when no stream data arrived for
+    /// a while.
+    Action write_wait()
+    {
+        if (!writeFlow_->is_busy())
+        {
+            return call_immediately(STATE(write_done));
+        }
+        if (!writeFlow_->take_progress())
+        {
+            LOG(INFO, "MemoryConfig: write stream timed out.");
+            writeFlow_->cancel(Defs::ERROR_OPENLCB_TIMEOUT);
+        }
+        return sleep_and_call(&timer_,
+            MSEC_TO_NSEC(config_stream_write_timeout_msec()),
+            STATE(write_wait));
+    }
+
+    /// Called when the entire stream is written into the memory space (or the
+    /// write failed).
+    Action write_done()
+    {
+        uint16_t error = writeFlow_->get_error();
+        size_t response_data_offset = 6;
+        if (has_custom_space())
+        {
+            ++response_data_offset;
+        }
+        response_.resize(response_data_offset + 2);
+        uint8_t *response_bytes = out_bytes();
+        response_bytes[0] = DATAGRAM_ID;
+        response_bytes[1] = error
+            ? MemoryConfigDefs::COMMAND_WRITE_STREAM_FAILED
+            : MemoryConfigDefs::COMMAND_WRITE_STREAM_REPLY;
+        set_address_and_space();
+        if (error)
+        {
+            response_bytes[response_data_offset] = error >> 8;
+            response_bytes[response_data_offset + 1] = error & 0xff;
+        }
+        else
+        {
+            response_bytes[response_data_offset] =
+                writeFlow_->get_src_stream_id();
+            response_bytes[response_data_offset + 1] =
+                writeFlow_->get_dst_stream_id();
+        }
+        return call_immediately(STATE(ok_response_sent));
+    }
+
     /** Looks up the memory space for the current datagram. Returns NULL if no
      * space was registered (for neither the current node, nor global). */
     MemorySpace *get_space()
@@ -431,6 +730,30 @@ private:
         /// stream.
         MemorySpaceStreamReadFlow *readFlow_;
     };
+
+    /// The flow that receives write streams into the memory space. Created
+    /// upon the first write stream command.
+    std::unique_ptr<MemorySpaceStreamWriteFlow> writeFlow_;
+
+    /// Wakes up the write_wait state when the write flow is done.
+    class WriteDone : public Notifiable
+    {
+    public:
+        WriteDone(MemoryConfigStreamHandler *parent)
+            : parent_(parent)
+        { }
+
+        void notify() override
+        {
+            parent_->timer_.ensure_triggered();
+        }
+
+    private:
+        MemoryConfigStreamHandler *parent_;
+    } writeDone_ {this};
+
+    /// Timeout for the write streams.
+    StateFlowTimer timer_ {this};
 }; // class MemoryConfigStreamHandler
 
 } // namespace openlcb
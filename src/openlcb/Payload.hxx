@@ -40,6 +40,18 @@
 
 namespace openlcb {
 
+/// Data content of an OpenLCB message.
+///
+/// This is a std::string. With the C++11 ABI of libstdc++ (host, ARM and
+/// other recent GCC/clang toolchains) it stores up to 15 bytes inline without
+/// touching the heap, which covers the payload of every single-frame CAN
+/// message (events, verify node ID, traction commands etc). Longer payloads,
+/// such as datagrams and SNIP replies, spill to the heap.
+///
+/// Older toolchains (e.g. mips-sde-elf for PIC32MX, xtensa-lx106) ship a
+/// copy-on-write std::string, which allocates for every non-empty payload.
+///
+/// @todo add an inline payload type for those toolchains.
 typedef string Payload;
 
 } // namespace openlcb
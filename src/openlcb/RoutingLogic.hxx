@@ -108,6 +108,17 @@ public:
         addressRoutingTable_[source] = port;
     }
 
+    /** Forgets the route of a given node, for example because the node has
+     * released its address.
+     *
+     * @param source is the address of the node that went away.
+     */
+    void remove_node_id(Address source)
+    {
+        OSMutexLock l(&lock_);
+        addressRoutingTable_.erase(source);
+    }
+
     /** Looks up which port an addressed packet should be sent to.
      *
      * @param dest is the address of the destination node that needs to be
@@ -158,9 +169,8 @@ public:
      * that port. */
     void register_producer(Port *port, EventId event)
     {
-        // For the moment we do not keep separate routing tables for producers
-        // and consumers.
-        register_consumer(port, event);
+        OSMutexLock l(&lock_);
+        eventRoutingTable_[port].registeredProducers_[0].insert(event);
     }
 
     /** Declares that there is a producer for the given event ID range on the
@@ -171,9 +181,10 @@ public:
      * method. */
     void register_producer_range(Port *port, EventId encoded_range)
     {
-        // For the moment we do not keep separate routing tables for producers
-        // and consumers.
-        register_consumer_range(port, encoded_range);
+        OSMutexLock l(&lock_);
+        uint8_t bit_count = event_range_to_bit_count(&encoded_range);
+        eventRoutingTable_[port].registeredProducers_[bit_count].insert(
+            encoded_range);
     }
 
     /** Checks if a given PCER message should be forwarded to the given port.
@@ -190,8 +201,37 @@ public:
         {
             return false;
         }
-        for (auto im = ip->second.registeredConsumers_.begin();
-             im != ip->second.registeredConsumers_.end(); ++im)
+        return match_event(ip->second.registeredConsumers_, event);
+    }
+
+    /** Checks if a producer for a given event was seen on the given port.
+     *
+     * @param port is the port to query.
+     * @param event is the event ID.
+     *
+     * @return true if the given event has a producer on the given port. */
+    bool check_producer(Port *port, EventId event)
+    {
+        OSMutexLock l(&lock_);
+        auto ip = eventRoutingTable_.find(port);
+        if (ip == eventRoutingTable_.end())
+        {
+            return false;
+        }
+        return match_event(ip->second.registeredProducers_, event);
+    }
+
+private:
+    /// Events and event ranges. Key: number of bits set in the mask
+    /// part. Valid values: 0..64. Value of 0 means individual event.
+    typedef std::map<uint8_t, std::set<EventId>> EventRanges;
+
+    /** @return true if an event is in a set of events and ranges.
+     * @param ranges the set of events and ranges.
+     * @param event the event ID to look for. */
+    static bool match_event(const EventRanges &ranges, EventId event)
+    {
+        for (auto im = ranges.begin(); im != ranges.end(); ++im)
         {
             if (im->first == 0)
             {
@@ -214,7 +254,6 @@ public:
         return false;
     }
 
-private:
     /// Protects all internal data structures.
     OSMutex lock_;
 
@@ -224,9 +263,11 @@ private:
     /// The per-port event information.
     struct EventSet
     {
-        /// key: number of bits set in the mask part. Valid values:
-        /// 0..64. Value of 0 means individual event.
-        std::map<uint8_t, std::set<EventId>> registeredConsumers_;
+        /// Consumers seen on the port. PCER messages are forwarded based on
+        /// these.
+        EventRanges registeredConsumers_;
+        /// Producers seen on the port.
+        EventRanges registeredProducers_;
     };
 
     /// Stores per-port event information.
@@ -101,16 +101,25 @@ SimpleTcpStack::SimpleTcpStack(const openlcb::NodeID node_id)
 {
 }
 
-void SimpleCanStackBase::add_stream_support()
+void SimpleStackBase::add_stream_support()
 {
-    Destructable *t =
-        new StreamTransportCan(if_can(), config_num_stream_senders());
+    Destructable *t = create_stream_transport();
     additionalComponents_.emplace_back(t);
     Destructable *mem_stream =
         new MemoryConfigStreamHandler(memory_config_handler());
     additionalComponents_.emplace_back(mem_stream);
 }
 
+StreamTransport *SimpleCanStackBase::create_stream_transport()
+{
+    return new StreamTransportCan(if_can(), config_num_stream_senders());
+}
+
+StreamTransport *SimpleTcpStackBase::create_stream_transport()
+{
+    return new StreamTransportTcp(if_tcp(), config_num_stream_senders());
+}
+
 void SimpleStackBase::start_stack(bool delay_start)
 {
 #if OPENMRN_HAVE_POSIX_FD
@@ -122,6 +131,11 @@ void SimpleStackBase::start_stack(bool delay_start)
     {
         configUpdateFlow_.open_file(CONFIG_FILENAME);
     }
+    if (config_cache_config_file() == CONSTANT_TRUE && CONFIG_FILE_SIZE > 0)
+    {
+        configCache_.reset(new ConfigCache(
+            configUpdateFlow_.get_fd(), CONFIG_FILE_SIZE, executor()));
+    }
     configUpdateFlow_.init_flow();
 #endif // have posix fd
 
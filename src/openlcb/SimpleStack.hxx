@@ -72,6 +72,8 @@ class OpenMRN;
 namespace openlcb
 {
 
+class StreamTransport;
+
 /// This symbol contains the embedded text of the CDI xml file.
 extern const char CDI_DATA[];
 
@@ -155,6 +157,26 @@ public:
         return &configUpdateFlow_;
     }
 
+    /// Enables stream transport in the interface and in the memory config
+    /// protocol.
+    void add_stream_support();
+
+    /// Helper class to add stream support straight after construction.
+    /// Usage: add following at toplevel in main.cxx
+    /// ```
+    /// SimpleCanStack stack(NODE_ID);
+    /// SimpleCanStack::WithStreamSupport stream_support(&stack);
+    /// ```
+    /// This works the same way with SimpleTcpStack.
+    class WithStreamSupport
+    {
+    public:
+        WithStreamSupport(SimpleStackBase *p)
+        {
+            p->add_stream_support();
+        }
+    };
+
     /// Adds an activiy LED which will be flashed every time a message is sent
     /// from this node to the network.
     /// @param gpio LED that will be flashed on for each packet.
@@ -268,6 +290,11 @@ protected:
     /// Hook for clients to initialize the node-specific components.
     virtual void start_node() = 0;
 
+    /// Hook for descendant classes to create the stream transport that
+    /// matches the interface. Called by add_stream_support().
+    /// @return a new stream transport. Ownership is transferred to the caller.
+    virtual StreamTransport *create_stream_transport() = 0;
+
     /// Exports the memory config spaces that are typically used for a complex
     /// node. Expected to be called from start_node().
     void default_start_node();
@@ -285,6 +312,9 @@ protected:
     DatagramService *datagramService_ {ifaceHolder_->datagram_service()};
     /// Calls the config listeners with the configuration FD.
     ConfigUpdateFlow configUpdateFlow_ {iface()};
+    /// In-memory mirror of the config file. Only created if the
+    /// cache_config_file constant is set.
+    std::unique_ptr<ConfigCache> configCache_;
     /// The initialization flow takes care for node startup duties.
     InitializeFlow initFlow_ {&service_};
     /// Dispatches event protocol requests to the event handlers.
@@ -439,28 +469,12 @@ public:
         return &static_cast<CanPhysicalIf *>(ifaceHolder_.get())->ifCan_;
     }
 
-    /// Enables stream transport in the interface and in the memory config
-    /// protocol.
-    void add_stream_support();
-
-    /// Helper class to add stream support straight after construction.
-    /// Usage: add following at toplevel in main.cxx
-    /// ```
-    /// SimpleCanStack stack(NODE_ID);
-    /// SimpleCanStack::WithStreamSupport stream_support(&stack);
-    /// ```
-    class WithStreamSupport
-    {
-    public:
-        WithStreamSupport(SimpleCanStackBase *p)
-        {
-            p->add_stream_support();
-        }
-    };
-
 protected:
     /// Helper function for start_stack et al.
     void start_iface(bool restart) override;
+
+    /// @return a stream transport sending stream data in CAN frames.
+    StreamTransport *create_stream_transport() override;
     
 private:
     class CanPhysicalIf : public PhysicalIf
@@ -532,6 +546,10 @@ protected:
     /// Helper function for start_stack et al.
     void start_iface(bool restart) override;
 
+    /// @return a stream transport sending stream data in OpenLCB-TCP
+    /// messages.
+    StreamTransport *create_stream_transport() override;
+
 private:
     /// This function is not safe to use. There is an expectation that only
     /// complete OpenLCB-TCP packets are submitted to this hub. Use the
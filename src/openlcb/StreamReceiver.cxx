@@ -45,7 +45,7 @@
 namespace openlcb
 {
 
-void StreamReceiverCan::announced_stream()
+void StreamReceiverBase::announced_stream()
 {
     // Resets state bits.
     streamClosed_ = 0;
@@ -63,7 +63,7 @@ void StreamReceiverCan::announced_stream()
         Defs::MTI_STREAM_INITIATE_REQUEST, Defs::MTI_EXACT);
 }
 
-void StreamReceiverCan::send(Buffer<StreamReceiveRequest> *msg, unsigned prio)
+void StreamReceiverBase::send(Buffer<StreamReceiveRequest> *msg, unsigned prio)
 {
     reset_message(msg, prio);
 
@@ -84,7 +84,7 @@ void StreamReceiverCan::send(Buffer<StreamReceiveRequest> *msg, unsigned prio)
     wait_for_wakeup();
 }
 
-void StreamReceiverCan::handle_stream_initiate(Buffer<GenMessage> *message)
+void StreamReceiverBase::handle_stream_initiate(Buffer<GenMessage> *message)
 {
     auto rb = get_buffer_deleter(message);
 
@@ -147,7 +147,7 @@ void StreamReceiverCan::handle_stream_initiate(Buffer<GenMessage> *message)
     notify();
 }
 
-void StreamReceiverCan::handle_bytes_received(const uint8_t *data, size_t len)
+void StreamReceiverBase::handle_bytes_received(const uint8_t *data, size_t len)
 {
     while (len > 0)
     {
@@ -195,7 +195,7 @@ void StreamReceiverCan::handle_bytes_received(const uint8_t *data, size_t len)
     }
 }
 
-void StreamReceiverCan::handle_stream_complete(Buffer<GenMessage> *message)
+void StreamReceiverBase::handle_stream_complete(Buffer<GenMessage> *message)
 {
     auto rb = get_buffer_deleter(message);
 
@@ -251,57 +251,8 @@ void StreamReceiverCan::handle_stream_complete(Buffer<GenMessage> *message)
         &streamCompleteHandler_, Defs::MTI_STREAM_COMPLETE, Defs::MTI_EXACT);
 }
 
-class StreamReceiverCan::StreamDataHandler : public IncomingFrameHandler
-{
-public:
-    StreamDataHandler(StreamReceiverCan *parent)
-        : parent_(parent)
-    { }
-
-    /// Starts registration for receiving stream data with the given aliases.
-    void start(NodeAlias remote_alias, NodeAlias local_alias)
-    {
-        HASSERT(remote_alias);
-        HASSERT(local_alias);
-        uint32_t frame_id = 0;
-        CanDefs::set_datagram_fields(
-            &frame_id, remote_alias, local_alias, CanDefs::STREAM_DATA);
-        LOG(VERBOSE, "register frame ID %x", (unsigned)frame_id);
-        parent_->if_can()->frame_dispatcher()->register_handler(
-            this, frame_id, CanDefs::STREAM_DG_RECV_MASK);
-    }
-
-    /// Stops receiving stream data.
-    void stop()
-    {
-        parent_->if_can()->frame_dispatcher()->unregister_handler_all(this);
-    }
-
-    /// Handler callback for incoming messages.
-    void send(Buffer<CanMessageData> *message, unsigned priority) override
-    {
-        auto rb = get_buffer_deleter(message);
-
-        if (message->data()->can_dlc <= 0)
-        {
-            return; // no payload
-        }
-        if (message->data()->data[0] != parent_->request()->localStreamId_)
-        {
-            return; // different stream
-        }
-        parent_->handle_bytes_received(
-            message->data()->data + 1, message->data()->can_dlc - 1);
-    }
-
-private:
-    /// Owning stream receiver object.
-    StreamReceiverCan *parent_;
-};
-
-StreamReceiverCan::StreamReceiverCan(IfCan *interface, uint8_t local_stream_id)
+StreamReceiverBase::StreamReceiverBase(If *interface, uint8_t local_stream_id)
     : StreamReceiverInterface(interface)
-    , dataHandler_(new StreamDataHandler(this))
     , assignedStreamId_(local_stream_id)
     , streamClosed_(0)
     , pendingInit_(0)
@@ -309,10 +260,10 @@ StreamReceiverCan::StreamReceiverCan(IfCan *interface, uint8_t local_stream_id)
     , isWaiting_(0)
 { }
 
-StreamReceiverCan::~StreamReceiverCan()
+StreamReceiverBase::~StreamReceiverBase()
 { }
 
-void StreamReceiverCan::cancel_request()
+void StreamReceiverBase::cancel_request()
 {
     pendingCancel_ = 1;
     if (isWaiting_)
@@ -322,16 +273,16 @@ void StreamReceiverCan::cancel_request()
     }
 }
 
-void StreamReceiverCan::unregister_handlers()
+void StreamReceiverBase::unregister_handlers()
 {
-    dataHandler_->stop();
+    stop_data();
     node()->iface()->dispatcher()->unregister_handler_all(
         &streamInitiateHandler_);
     node()->iface()->dispatcher()->unregister_handler_all(
         &streamCompleteHandler_);
 }
 
-StateFlowBase::Action StreamReceiverCan::wakeup()
+StateFlowBase::Action StreamReceiverBase::wakeup()
 {
     isWaiting_ = 0;
     // Checks reason for wakeup.
@@ -355,7 +306,7 @@ StateFlowBase::Action StreamReceiverCan::wakeup()
         if (streamClosed_)
         {
             streamClosed_ = 0;
-            dataHandler_->stop();
+            stop_data();
             if (currentBuffer_)
             {
                 // Sends off the buffer and clears currentBuffer_.
@@ -369,21 +320,19 @@ StateFlowBase::Action StreamReceiverCan::wakeup()
     return wait();
 }
 
-StateFlowBase::Action StreamReceiverCan::init_reply()
+StateFlowBase::Action StreamReceiverBase::init_reply()
 {
     // Initialize the last buffer for the first window.
     return allocate_and_call<RawData>(
         nullptr, STATE(init_buffer_ready), &lastBufferPool_);
 }
 
-StateFlowBase::Action StreamReceiverCan::init_buffer_ready()
+StateFlowBase::Action StreamReceiverBase::init_buffer_ready()
 {
     lastBuffer_.reset(get_allocation_result<RawData>(nullptr));
 
     node()->iface()->canonicalize_handle(&request()->src_);
-    NodeHandle local(node()->node_id());
-    node()->iface()->canonicalize_handle(&local);
-    dataHandler_->start(request()->src_.alias, local.alias);
+    start_data();
 
     send_message(node(), Defs::MTI_STREAM_INITIATE_REPLY, request()->src_,
         StreamDefs::create_initiate_response(request()->streamWindowSize_,
@@ -392,13 +341,13 @@ StateFlowBase::Action StreamReceiverCan::init_buffer_ready()
     return wait_for_wakeup();
 }
 
-StateFlowBase::Action StreamReceiverCan::window_reached()
+StateFlowBase::Action StreamReceiverBase::window_reached()
 {
     return allocate_and_call<RawData>(
         nullptr, STATE(have_raw_buffer), &lastBufferPool_);
 }
 
-StateFlowBase::Action StreamReceiverCan::have_raw_buffer()
+StateFlowBase::Action StreamReceiverBase::have_raw_buffer()
 {
     lastBuffer_.reset(get_allocation_result<RawData>(nullptr));
     streamWindowRemaining_ = request()->streamWindowSize_;
@@ -408,4 +357,113 @@ StateFlowBase::Action StreamReceiverCan::have_raw_buffer()
     return wait_for_wakeup();
 }
 
+class StreamReceiverCan::StreamDataHandler : public IncomingFrameHandler
+{
+public:
+    StreamDataHandler(StreamReceiverCan *parent)
+        : parent_(parent)
+    { }
+
+    /// Starts registration for receiving stream data with the given aliases.
+    void start(NodeAlias remote_alias, NodeAlias local_alias)
+    {
+        HASSERT(remote_alias);
+        HASSERT(local_alias);
+        uint32_t frame_id = 0;
+        CanDefs::set_datagram_fields(
+            &frame_id, remote_alias, local_alias, CanDefs::STREAM_DATA);
+        LOG(VERBOSE, "register frame ID %x", (unsigned)frame_id);
+        parent_->if_can()->frame_dispatcher()->register_handler(
+            this, frame_id, CanDefs::STREAM_DG_RECV_MASK);
+    }
+
+    /// Stops receiving stream data.
+    void stop()
+    {
+        parent_->if_can()->frame_dispatcher()->unregister_handler_all(this);
+    }
+
+    /// Handler callback for incoming messages.
+    void send(Buffer<CanMessageData> *message, unsigned priority) override
+    {
+        auto rb = get_buffer_deleter(message);
+
+        if (message->data()->can_dlc <= 0)
+        {
+            return; // no payload
+        }
+        if (message->data()->data[0] != parent_->request()->localStreamId_)
+        {
+            return; // different stream
+        }
+        parent_->handle_bytes_received(
+            message->data()->data + 1, message->data()->can_dlc - 1);
+    }
+
+private:
+    /// Owning stream receiver object.
+    StreamReceiverCan *parent_;
+};
+
+StreamReceiverCan::StreamReceiverCan(IfCan *interface, uint8_t local_stream_id)
+    : StreamReceiverBase(interface, local_stream_id)
+    , dataHandler_(new StreamDataHandler(this))
+{ }
+
+StreamReceiverCan::~StreamReceiverCan()
+{ }
+
+void StreamReceiverCan::start_data()
+{
+    NodeHandle local(node()->node_id());
+    node()->iface()->canonicalize_handle(&local);
+    dataHandler_->start(request()->src_.alias, local.alias);
+}
+
+void StreamReceiverCan::stop_data()
+{
+    dataHandler_->stop();
+}
+
+StreamReceiverTcp::StreamReceiverTcp(If *interface, uint8_t local_stream_id)
+    : StreamReceiverBase(interface, local_stream_id)
+{ }
+
+StreamReceiverTcp::~StreamReceiverTcp()
+{ }
+
+void StreamReceiverTcp::start_data()
+{
+    node()->iface()->dispatcher()->register_handler(
+        &streamDataHandler_, Defs::MTI_STREAM_DATA, Defs::MTI_EXACT);
+}
+
+void StreamReceiverTcp::stop_data()
+{
+    node()->iface()->dispatcher()->unregister_handler_all(&streamDataHandler_);
+}
+
+void StreamReceiverTcp::handle_stream_data(Buffer<GenMessage> *message)
+{
+    auto rb = get_buffer_deleter(message);
+
+    if (message->data()->dstNode != node() ||
+        !node()->iface()->matching_node(request()->src_, message->data()->src))
+    {
+        // Not for me.
+        return;
+    }
+    const auto &payload = message->data()->payload;
+    if (payload.empty())
+    {
+        return; // no payload
+    }
+    if ((uint8_t)payload[0] != request()->localStreamId_)
+    {
+        return; // different stream
+    }
+    handle_bytes_received(
+        (const uint8_t *)payload.data() + 1, payload.size() - 1);
+}
+
 } // namespace openlcb
@@ -46,17 +46,20 @@
 namespace openlcb
 {
 
-class StreamReceiverCan : public StreamReceiverInterface
+/// Implements the transport independent parts of receiving a stream (stream
+/// initiate, window handling and stream complete). The derived classes define
+/// how the stream data arrives from the wire.
+class StreamReceiverBase : public StreamReceiverInterface
 {
 public:
     /// Constructor.
     ///
-    /// @param interface the CAN interface that owns this stream receiver.
+    /// @param interface the interface that owns this stream receiver.
     /// @param local_stream_id what should be the local stream ID for the
     /// streams used for this receiver.
-    StreamReceiverCan(IfCan *interface, uint8_t local_stream_id);
+    StreamReceiverBase(If *interface, uint8_t local_stream_id);
 
-    ~StreamReceiverCan();
+    ~StreamReceiverBase();
 
     /// Implements the flow interface for the request API. This is not based on
     /// entry() because the registration has to be synchrnous with the calling
@@ -67,7 +70,24 @@ public:
     /// then be asynchronously returned using the regular mechanism with a
     /// temporary error.
     void cancel_request() override;
-    
+
+protected:
+    /// Starts receiving stream data from the remote node. request()->src_ is
+    /// already canonicalized when this is called.
+    virtual void start_data() = 0;
+
+    /// Stops receiving stream data.
+    virtual void stop_data() = 0;
+
+    /// Handles data arriving from the network.
+    inline void handle_bytes_received(const uint8_t *data, size_t len);
+
+    /// @return the local node pointer.
+    Node *node()
+    {
+        return request()->dst_;
+    }
+
 private:
     /// Helper function for send() when a stream has to start synchronously.
     void announced_stream();
@@ -109,9 +129,6 @@ private:
     ///
     void handle_stream_initiate(Buffer<GenMessage> *message);
 
-    /// Handles data arriving from the network.
-    inline void handle_bytes_received(const uint8_t *data, size_t len);
-
     /// Invoked by the GenericHandler when a stream complete message arrives.
     ///
     /// @param message buffer with stream complete message.
@@ -120,29 +137,14 @@ private:
 
     /// Removes all handlers that are registered.
     void unregister_handlers();
-    
-    /// @return the local CAN interface.
-    IfCan *if_can()
-    {
-        return static_cast<IfCan *>(service());
-    }
-
-    /// @return the local node pointer.
-    Node *node()
-    {
-        return request()->dst_;
-    }
 
     /// Helper class for incoming message for stream initiate.
     MessageHandler::GenericHandler streamInitiateHandler_ {
-        this, &StreamReceiverCan::handle_stream_initiate};
-
-    class StreamDataHandler;
-    friend class StreamDataHandler;
+        this, &StreamReceiverBase::handle_stream_initiate};
 
     /// Helper class for incoming message for stream complete.
     MessageHandler::GenericHandler streamCompleteHandler_ {
-        this, &StreamReceiverCan::handle_stream_complete};
+        this, &StreamReceiverBase::handle_stream_complete};
 
     /// This pool is used to allocate one raw buffer per stream window
     /// size. This pool therefore functions as a throttling for the data
@@ -157,9 +159,6 @@ private:
     /// comes from the lastBufferPool_ to function as throttling signal.
     RawBufferPtr lastBuffer_;
 
-    /// Helper object that receives the actual stream CAN frames.
-    std::unique_ptr<StreamDataHandler> dataHandler_;
-
     /// How many bytes we have transmitted in this stream so far.
     size_t totalByteCount_;
 
@@ -178,7 +177,67 @@ private:
     uint8_t pendingCancel_ : 1;
     /// 1 if we are currently waiting for a notification
     uint8_t isWaiting_ : 1;
-}; // class StreamReceiver
+}; // class StreamReceiverBase
+
+/// Stream receiver for a CAN interface. Stream data arrives in stream data
+/// CAN frames.
+class StreamReceiverCan : public StreamReceiverBase
+{
+public:
+    /// Constructor.
+    ///
+    /// @param interface the CAN interface that owns this stream receiver.
+    /// @param local_stream_id what should be the local stream ID for the
+    /// streams used for this receiver.
+    StreamReceiverCan(IfCan *interface, uint8_t local_stream_id);
+
+    ~StreamReceiverCan();
+
+private:
+    void start_data() override;
+    void stop_data() override;
+
+    /// @return the local CAN interface.
+    IfCan *if_can()
+    {
+        return static_cast<IfCan *>(service());
+    }
+
+    class StreamDataHandler;
+    friend class StreamDataHandler;
+
+    /// Helper object that receives the actual stream CAN frames.
+    std::unique_ptr<StreamDataHandler> dataHandler_;
+}; // class StreamReceiverCan
+
+/// Stream receiver for an interface that transports OpenLCB messages directly,
+/// such as OpenLCB-TCP. Stream data arrives in addressed stream data messages.
+class StreamReceiverTcp : public StreamReceiverBase
+{
+public:
+    /// Constructor.
+    ///
+    /// @param interface the interface that owns this stream receiver.
+    /// @param local_stream_id what should be the local stream ID for the
+    /// streams used for this receiver.
+    StreamReceiverTcp(If *interface, uint8_t local_stream_id);
+
+    ~StreamReceiverTcp();
+
+private:
+    void start_data() override;
+    void stop_data() override;
+
+    /// Invoked by the GenericHandler when a stream data message arrives.
+    ///
+    /// @param message buffer with stream data message.
+    ///
+    void handle_stream_data(Buffer<GenMessage> *message);
+
+    /// Helper class for incoming stream data messages.
+    MessageHandler::GenericHandler streamDataHandler_ {
+        this, &StreamReceiverTcp::handle_stream_data};
+}; // class StreamReceiverTcp
 
 } // namespace openlcb
 
@@ -48,11 +48,19 @@
 namespace openlcb
 {
 
+/// Helper class for sending stream data to a remote node. This class
+/// implements the transport independent parts of the stream protocol (stream
+/// initiate, window handling, stream complete). The derived classes define how
+/// the payload is sent over the wire.
+/// @todo add progress report API.
 class StreamSender : public StateFlow<ByteBuffer, QList<1>>
 {
 public:
     StreamSender(Service *s)
         : StateFlow<ByteBuffer, QList<1>>(s)
+        , sleeping_(false)
+        , requestClose_(false)
+        , requestInit_(false)
     {
     }
 
@@ -74,21 +82,6 @@ public:
         /// An error occurred.
         STATE_ERROR
     };
-};
-
-/// Helper class for sending stream data to a CAN interface.
-/// @todo add progress report API.
-class StreamSenderCan : public StreamSender
-{
-public:
-    StreamSenderCan(Service *service, IfCan *iface)
-        : StreamSender(service)
-        , ifCan_(iface)
-        , sleeping_(false)
-        , requestClose_(false)
-        , requestInit_(false)
-    {
-    }
 
     /// Initiates using the stream sender. May be called only on idle stream
     /// senders.
@@ -102,7 +95,7 @@ public:
     ///
     /// @return *this for calling optional settings API commands.
     ///
-    StreamSenderCan &start_stream(Node *src, NodeHandle dst,
+    StreamSender &start_stream(Node *src, NodeHandle dst,
         uint8_t source_stream_id,
         uint8_t dst_stream_id = StreamDefs::INVALID_STREAM_ID)
     {
@@ -142,7 +135,7 @@ public:
     /// @param window_size in bytes, what should we propose in the stream
     /// initiate call
     ///
-    StreamSenderCan &set_proposed_window_size(uint16_t window_size)
+    StreamSender &set_proposed_window_size(uint16_t window_size)
     {
         HASSERT(state_ == STARTED);
         streamWindowSize_ = window_size;
@@ -155,7 +148,7 @@ public:
     ///
     /// @param stream_uid a valid 6-byte stream identifier.
     ///
-    StreamSenderCan &set_stream_uid(NodeID stream_uid)
+    StreamSender &set_stream_uid(NodeID stream_uid)
     {
         HASSERT(state_ == STARTED);
         /// @todo implement opening unannounced streams.
@@ -170,6 +163,20 @@ public:
         {
             state_ = IDLE;
         }
+        listener_ = nullptr;
+    }
+
+    /// Requests a one-shot notification when the stream sender reaches the
+    /// next state of interest to the local client: the stream is running, or
+    /// the sender is done with the stream (closed or error) and has consumed
+    /// all queued data. The listener should check get_state() and
+    /// is_waiting() when woken up, and call this function again if it needs
+    /// to continue waiting. Must be called on the interface's executor.
+    ///
+    /// @param n will be notified once, then forgotten.
+    void notify_on_state_change(Notifiable *n)
+    {
+        listener_ = n;
     }
 
 #ifdef GTEST
@@ -222,6 +229,10 @@ public:
         }
         if (state_ == STATE_ERROR || state_ == CLOSING)
         {
+            if (queue_empty())
+            {
+                notify_listener();
+            }
             return release_and_exit();
         }
         DASSERT(state_ == RUNNING);
@@ -241,7 +252,49 @@ public:
             }
             return release_and_exit();
         }
-        return call_immediately(STATE(allocate_can_buffer));
+        return call_immediately(STATE(send_payload));
+    }
+
+protected:
+    /// Sends the next piece of the current chunk of payload to the
+    /// destination. Called when there is payload to send and the stream
+    /// window is not exhausted. Implementations consume the bytes sent using
+    /// advance(), then continue with entry().
+    virtual Action send_payload() = 0;
+
+    /// @param max_len how many bytes of payload fit into one message or frame
+    /// on the transport.
+    /// @return how many bytes of data we can put into the next message.
+    size_t compute_next_length(size_t max_len)
+    {
+        size_t ret = remaining();
+        // Cannot exceed the transport's max payload.
+        if (ret > max_len)
+        {
+            ret = max_len;
+        }
+        // Cannot exceed remaining bytes in stream window.
+        if (ret > streamWindowRemaining_)
+        {
+            ret = streamWindowRemaining_;
+        }
+        return ret;
+    }
+
+    /// @return pointer to the beginning of the data to send.
+    uint8_t *payload()
+    {
+        return message()->data()->data_;
+    }
+
+    /// Consumes a certain number of bytes from the beginning of the data to
+    /// send.
+    /// @param num_bytes how much data to consume.
+    void advance(size_t num_bytes)
+    {
+        message()->data()->advance(num_bytes);
+        totalByteCount_ += num_bytes;
+        streamWindowRemaining_ -= num_bytes;
     }
 
 private:
@@ -252,6 +305,17 @@ private:
         this->send(b);
     }
 
+    /// Wakes up the local client waiting for a state change, if any.
+    void notify_listener()
+    {
+        Notifiable *n = listener_;
+        listener_ = nullptr;
+        if (n)
+        {
+            n->notify();
+        }
+    }
+
     /// Allocates a GenMessage buffer and sends out the stream initiate message
     /// to the destination.
     Action initiate_stream()
@@ -358,6 +422,7 @@ private:
         node_->iface()->dispatcher()->register_handler(
             &streamProceedHandler_, Defs::MTI_STREAM_PROCEED, Defs::MTI_EXACT);
         state_ = RUNNING;
+        notify_listener();
         return entry();
     }
 
@@ -385,45 +450,6 @@ private:
         return entry();
     }
 
-    /// Allocates a buffer for a CAN frame (for payload send).
-    Action allocate_can_buffer()
-    {
-        return allocate_and_call(
-            ifCan_->frame_write_flow(), STATE(got_frame), &canFramePool_);
-    }
-
-    /// Got a buffer for an output frame (payload send).
-    Action got_frame()
-    {
-        auto *b = get_allocation_result(ifCan_->frame_write_flow());
-
-        uint32_t can_id;
-        NodeAlias local_alias =
-            ifCan_->local_aliases()->lookup(node_->node_id());
-        NodeAlias remote_alias = dst_.alias;
-        CanDefs::set_datagram_fields(
-            &can_id, local_alias, remote_alias, CanDefs::STREAM_DATA);
-        auto *frame = b->data()->mutable_frame();
-        SET_CAN_FRAME_ID_EFF(*frame, can_id);
-
-        size_t len = compute_next_can_length();
-
-        frame->can_dlc = len + 1;
-        frame->data[0] = dstStreamId_;
-        memcpy(&frame->data[1], payload(), len);
-        advance(len);
-
-        if (!isLoopbackStream_)
-        {
-            ifCan_->frame_write_flow()->send(b);
-        }
-        else
-        {
-            ifCan_->loopback_frame_write_flow()->send(b);
-        }
-        return entry();
-    }
-
     /// Starts sleeping until a proceed message arrives. Run this state when
     /// streamWindowRemaining_ == 0.
     Action wait_for_stream_proceed()
@@ -481,52 +507,18 @@ private:
         return entry();
     }
 
-private:
-    /// @return how many bytes of data we can put into the next CAN frame.
-    size_t compute_next_can_length()
-    {
-        size_t ret = remaining();
-        // Cannot exceed CAN frame max payload.
-        if (ret > MAX_BYTES_PAYLOAD_PER_CAN_FRAME)
-        {
-            ret = MAX_BYTES_PAYLOAD_PER_CAN_FRAME;
-        }
-        // Cannot exceed remaining bytes in stream window.
-        if (ret > streamWindowRemaining_)
-        {
-            ret = streamWindowRemaining_;
-        }
-        return ret;
-    }
-
     /// @return the number of bytes available in the current chunk.
     size_t remaining()
     {
         return message()->data()->size_;
     }
 
-    /// @return pointer to the beginning of the data to send.
-    uint8_t *payload()
-    {
-        return message()->data()->data_;
-    }
-
-    /// Consumes a certain number of bytes from the beginning of the data to
-    /// send.
-    /// @param num_bytes how much data to consume.
-    void advance(size_t num_bytes)
-    {
-        message()->data()->advance(num_bytes);
-        totalByteCount_ += num_bytes;
-        streamWindowRemaining_ -= num_bytes;
-    }
-
     Action return_error(uint32_t code, string message)
     {
         LOG(INFO, "error %x: %s", (unsigned)code, message.c_str());
         errorCode_ = code;
         state_ = STATE_ERROR;
-        return release_and_exit();
+        return entry();
     }
 
     /// How many seconds for waiting for a stream proceed before we give up
@@ -537,42 +529,37 @@ private:
     /// with a timeout.
     static constexpr size_t STREAM_INIT_TIMEOUT_SEC = 20;
 
-    /// How many bytes payload we can copy into a single CAN frame.
-    static constexpr size_t MAX_BYTES_PAYLOAD_PER_CAN_FRAME = 7;
-
-    /// How many CAN frames should we allocate at a given time.
-    static constexpr size_t MAX_FRAMES_IN_FLIGHT = 4;
-
-    /// How many bytes the allocation of a single CAN frame should be.
-    static constexpr size_t CAN_FRAME_ALLOC_SIZE =
-        sizeof(CanFrameWriteFlow::message_type);
-
     /// Handles incoming stream proceed messages.
     MessageHandler::GenericHandler streamProceedHandler_ {
-        this, &StreamSenderCan::stream_proceed_received};
+        this, &StreamSender::stream_proceed_received};
     /// Handles incoming stream initiate reply messages.
     MessageHandler::GenericHandler streamInitiateReplyHandler_ {
-        this, &StreamSenderCan::stream_initiate_replied};
+        this, &StreamSender::stream_initiate_replied};
 
-    /// CAN-bus interface.
-    IfCan *ifCan_;
+protected:
     /// Which node are we sending the outgoing data from. This is a local
     /// virtual node.
     Node *node_ {nullptr};
     /// Destination node that we are sending to. It is important that the alias
     /// is filled in here.
     NodeHandle dst_;
+
+private:
     /// How many bytes we have transmitted in this stream so far.
     size_t totalByteCount_ {0};
     /// What state the current class is in.
     StreamSenderState state_ {IDLE};
     /// Stream ID at the source node. @todo fill in
     uint8_t localStreamId_ {StreamDefs::INVALID_STREAM_ID};
+
+protected:
     /// Stream ID at the destination node. @todo fill in
     uint8_t dstStreamId_ {StreamDefs::INVALID_STREAM_ID};
     /// Determines whether the stream transmission is happening to
     /// localhost. Almost never true.
     uint8_t isLoopbackStream_ : 1;
+
+private:
     /// True if we are waiting for the timer.
     uint8_t sleeping_ : 1;
     /// 1 if there is a pending close request.
@@ -589,12 +576,133 @@ private:
     uint16_t streamWindowRemaining_ {0};
     /// When the stream process fails, this variable contains an error code.
     uint32_t errorCode_ {0};
+    /// Helper object for timeouts.
+    StateFlowTimer timer_ {this};
+    /// Local client to wake up at the next state change.
+    Notifiable *listener_ {nullptr};
+};
+
+/// Helper class for sending stream data to a CAN interface. The payload is
+/// sent in stream data CAN frames.
+class StreamSenderCan : public StreamSender
+{
+public:
+    StreamSenderCan(Service *service, IfCan *iface)
+        : StreamSender(service)
+        , ifCan_(iface)
+    {
+    }
+
+private:
+    /// Allocates a buffer for a CAN frame (for payload send).
+    Action send_payload() override
+    {
+        return allocate_and_call(
+            ifCan_->frame_write_flow(), STATE(got_frame), &canFramePool_);
+    }
+
+    /// Got a buffer for an output frame (payload send).
+    Action got_frame()
+    {
+        auto *b = get_allocation_result(ifCan_->frame_write_flow());
+
+        uint32_t can_id;
+        NodeAlias local_alias =
+            ifCan_->local_aliases()->lookup(node_->node_id());
+        NodeAlias remote_alias = dst_.alias;
+        CanDefs::set_datagram_fields(
+            &can_id, local_alias, remote_alias, CanDefs::STREAM_DATA);
+        auto *frame = b->data()->mutable_frame();
+        SET_CAN_FRAME_ID_EFF(*frame, can_id);
+
+        size_t len = compute_next_length(MAX_BYTES_PAYLOAD_PER_CAN_FRAME);
+
+        frame->can_dlc = len + 1;
+        frame->data[0] = dstStreamId_;
+        memcpy(&frame->data[1], payload(), len);
+        advance(len);
+
+        if (!isLoopbackStream_)
+        {
+            ifCan_->frame_write_flow()->send(b);
+        }
+        else
+        {
+            ifCan_->loopback_frame_write_flow()->send(b);
+        }
+        return entry();
+    }
+
+    /// How many bytes payload we can copy into a single CAN frame.
+    static constexpr size_t MAX_BYTES_PAYLOAD_PER_CAN_FRAME = 7;
+
+    /// How many CAN frames should we allocate at a given time.
+    static constexpr size_t MAX_FRAMES_IN_FLIGHT = 4;
+
+    /// How many bytes the allocation of a single CAN frame should be.
+    static constexpr size_t CAN_FRAME_ALLOC_SIZE =
+        sizeof(CanFrameWriteFlow::message_type);
+
+    /// CAN-bus interface.
+    IfCan *ifCan_;
     /// Source of buffers for outgoing CAN frames. Limtedpool is allocating and
     /// releasing to the mainBufferPool, but blocks when we exceed a certain
     /// number of allocations until some buffers get freed.
     LimitedPool canFramePool_ {CAN_FRAME_ALLOC_SIZE, MAX_FRAMES_IN_FLIGHT};
-    /// Helper object for timeouts.
-    StateFlowTimer timer_ {this};
+};
+
+/// Helper class for sending stream data to an interface that transports
+/// OpenLCB messages directly, such as OpenLCB-TCP. The payload is sent in
+/// addressed stream data messages, each carrying up to a kilobyte, instead
+/// of 7-byte CAN frames.
+class StreamSenderTcp : public StreamSender
+{
+public:
+    StreamSenderTcp(Service *service, If *iface)
+        : StreamSender(service)
+        , iface_(iface)
+    {
+    }
+
+private:
+    /// Allocates a buffer for a stream data message.
+    Action send_payload() override
+    {
+        return allocate_and_call(iface_->addressed_message_write_flow(),
+            STATE(got_message), &messagePool_);
+    }
+
+    /// Got a buffer for an output message (payload send).
+    Action got_message()
+    {
+        auto *b = get_allocation_result(iface_->addressed_message_write_flow());
+
+        size_t len = compute_next_length(MAX_BYTES_PAYLOAD_PER_MESSAGE);
+
+        Payload p;
+        p.reserve(len + 1);
+        p.push_back(dstStreamId_);
+        p.append((const char *)payload(), len);
+        advance(len);
+
+        b->data()->reset(
+            Defs::MTI_STREAM_DATA, node_->node_id(), dst_, std::move(p));
+        iface_->addressed_message_write_flow()->send(b);
+        return entry();
+    }
+
+    /// How many bytes payload we copy into a single stream data message.
+    static constexpr size_t MAX_BYTES_PAYLOAD_PER_MESSAGE = RawData::MAX_SIZE;
+
+    /// How many stream data messages should we allocate at a given time.
+    static constexpr size_t MAX_MESSAGES_IN_FLIGHT = 4;
+
+    /// OpenLCB interface to send the messages to.
+    If *iface_;
+    /// Source of buffers for outgoing messages. Limits how much payload is
+    /// buffered in the interface's send queue.
+    LimitedPool messagePool_ {
+        sizeof(Buffer<GenMessage>), MAX_MESSAGES_IN_FLIGHT};
 };
 
 class StreamRendererCan : public StateFlow<ByteBuffer, QList<1>>
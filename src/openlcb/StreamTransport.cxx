@@ -34,6 +34,7 @@
 
 #include "openlcb/StreamTransport.hxx"
 
+#include "openlcb/StreamReceiver.hxx"
 #include "openlcb/StreamSender.hxx"
 
 namespace openlcb
@@ -52,6 +53,7 @@ StreamTransport::~StreamTransport()
 
 StreamTransportCan::StreamTransportCan(IfCan *iface, unsigned num_senders)
     : StreamTransport(iface)
+    , ifCan_(iface)
 {
     for (unsigned i = 0; i < num_senders; ++i)
     {
@@ -63,4 +65,30 @@ StreamTransportCan::~StreamTransportCan()
 {
 }
 
+StreamReceiverInterface *StreamTransportCan::create_receiver(
+    uint8_t local_stream_id)
+{
+    return new StreamReceiverCan(ifCan_, local_stream_id);
+}
+
+StreamTransportTcp::StreamTransportTcp(If *iface, unsigned num_senders)
+    : StreamTransport(iface)
+    , iface_(iface)
+{
+    for (unsigned i = 0; i < num_senders; ++i)
+    {
+        senders_.typed_insert(new StreamSenderTcp(iface, iface));
+    }
+}
+
+StreamTransportTcp::~StreamTransportTcp()
+{
+}
+
+StreamReceiverInterface *StreamTransportTcp::create_receiver(
+    uint8_t local_stream_id)
+{
+    return new StreamReceiverTcp(iface_, local_stream_id);
+}
+
 } // namespace openlcb
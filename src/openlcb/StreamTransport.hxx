@@ -44,6 +44,7 @@ namespace openlcb
 {
 
 class StreamSender;
+class StreamReceiverInterface;
 class IfCan;
 class If;
 
@@ -105,6 +106,16 @@ public:
         return nextReceiveStreamId_++;
     }
 
+    /// Creates a stream receiver that works with the interface of this
+    /// transport.
+    ///
+    /// @param local_stream_id the local stream ID for the streams used by
+    /// this receiver.
+    ///
+    /// @return a new stream receiver. Ownership is transferred to the caller.
+    virtual StreamReceiverInterface *create_receiver(
+        uint8_t local_stream_id) = 0;
+
 protected:
     /// Stream Sender objects.
     TypedQAsync<StreamSender> senders_;
@@ -135,6 +146,34 @@ public:
 
     /// Destructor.
     ~StreamTransportCan();
+
+    StreamReceiverInterface *create_receiver(uint8_t local_stream_id) override;
+
+private:
+    /// Interface that we are bound to.
+    IfCan *ifCan_;
+};
+
+/// Stream transport for interfaces that carry OpenLCB messages directly, such
+/// as OpenLCB-TCP. Stream data is sent in addressed stream data messages of up
+/// to a kilobyte each, using the same window negotiation as on CAN.
+class StreamTransportTcp : public StreamTransport
+{
+public:
+    /// Constructor
+    ///
+    /// @param iface OpenLCB interface object pointer (typically an IfTcp).
+    /// @param num_senders How many stream senders to instantiate.
+    StreamTransportTcp(If *iface, unsigned num_senders);
+
+    /// Destructor.
+    ~StreamTransportTcp();
+
+    StreamReceiverInterface *create_receiver(uint8_t local_stream_id) override;
+
+private:
+    /// Interface that we are bound to.
+    If *iface_;
 };
 
 } // namespace openlcb
@@ -54,14 +54,6 @@ TrainNode::~TrainNode()
 {
 }
 
-TrainNodeWithConsist::~TrainNodeWithConsist()
-{
-    while (!consistSlaves_.empty())
-    {
-        delete consistSlaves_.pop_front();
-    }
-}
-
 DefaultTrainNode::~DefaultTrainNode()
 {
 }
@@ -118,11 +110,11 @@ struct TrainService::Impl
 
     /// Handler for incoming OpenLCB messages of MTI == Traction Protocol
     /// Request.
-    class TractionRequestFlow : public IncomingMessageStateFlow
+    class TractionRequestFlow : public MessageStateFlowBase
     {
     public:
         TractionRequestFlow(TrainService *service)
-            : IncomingMessageStateFlow(service->iface())
+            : MessageStateFlowBase(service)
             , reserved_(0)
             , trainService_(service)
             , response_(nullptr)
@@ -138,6 +130,37 @@ struct TrainService::Impl
         }
 
     protected:
+        /// @return the interface the train nodes are bound to.
+        If *iface()
+        {
+            return trainService_->iface();
+        }
+
+        /// @return the message we received.
+        GenMessage *nmsg()
+        {
+            return message()->data();
+        }
+
+        /// Compares two node handles like If::matching_node. The alias caches
+        /// are owned by the interface's executor, so when the traction flow
+        /// runs on a different executor, the lookup is done over there.
+        bool matching_node(NodeHandle expected, NodeHandle actual)
+        {
+            if (expected.id && actual.id)
+            {
+                return expected.id == actual.id;
+            }
+            if (service()->executor() == iface()->executor())
+            {
+                return iface()->matching_node(expected, actual);
+            }
+            bool ret = false;
+            iface()->executor()->sync_run(
+                [&]() { ret = iface()->matching_node(expected, actual); });
+            return ret;
+        }
+
         TrainNode *train_node()
         {
             return static_cast<TrainNode *>(nmsg()->dstNode);
@@ -174,7 +197,14 @@ struct TrainService::Impl
                 return release_and_exit();
             }
             // Checks if destination is a local traction-enabled node.
-            if (!trainService_->nodes_->is_node_registered(train_node()))
+            bool registered;
+            {
+                // Trains may be registered from other threads.
+                AtomicHolder h(trainService_);
+                registered =
+                    trainService_->nodes_->is_node_registered(train_node());
+            }
+            if (!registered)
             {
                 LOG(VERBOSE, "Traction message for node %p that is not "
                              "traction enabled.",
@@ -201,7 +231,6 @@ struct TrainService::Impl
                 {
                     SpeedType sp = fp16_to_speed(payload() + 1);
                     train_node()->train()->set_speed(sp);
-                    nextConsistIndex_ = 0;
                     return call_immediately(STATE(maybe_forward_consist));
                 }
                 case TractionDefs::REQ_SET_FN:
@@ -232,13 +261,11 @@ struct TrainService::Impl
                     {
                         train_node()->train()->set_fn(address, value);
                     }
-                    nextConsistIndex_ = 0;
                     return call_immediately(STATE(maybe_forward_consist));
                 }
                 case TractionDefs::REQ_EMERGENCY_STOP:
                 {
                     train_node()->train()->set_emergencystop();
-                    nextConsistIndex_ = 0;
                     return call_immediately(STATE(maybe_forward_consist));
                 }
                 case TractionDefs::REQ_QUERY_SPEED: // fall through
@@ -341,8 +368,8 @@ struct TrainService::Impl
                         train_node()->get_controller();
                     if (false && // TODO(balazs.racz) this will automatically "steal" the loco but forgets to notify the old controller that it's stolen.
                         existing_controller.id &&
-                        !iface()->matching_node(existing_controller,
-                                                supplied_controller))
+                        !matching_node(
+                            existing_controller, supplied_controller))
                     {
                         /** @TODO (balazs.racz): we need to implement stealing
                          * a train from the existing controller. */
@@ -385,8 +412,8 @@ struct TrainService::Impl
                     }
                     NodeHandle existing_controller =
                         train_node()->get_controller();
-                    if (!iface()->matching_node(existing_controller,
-                                                    supplied_controller))
+                    if (!matching_node(
+                            existing_controller, supplied_controller))
                     {
                         LOG(WARNING,
                             "Tried to release a train that was not held: "
@@ -460,92 +487,101 @@ struct TrainService::Impl
             }
         }
 
-        Action maybe_forward_consist()
+        /// Decides whether the current command needs to be forwarded to a
+        /// given consist member.
+        /// @param dst node ID of the consist member.
+        /// @param flags consist flags of the member.
+        /// @return true if the member should get a copy of the command.
+        bool should_forward(NodeID dst, uint8_t flags)
         {
-            auto* train_node = this->train_node();
-            unsigned count = train_node->query_consist_length();
-            if (count <= nextConsistIndex_)
-                return release_and_exit();
-            uint8_t flags = 0;
-            NodeID dst = train_node->query_consist(nextConsistIndex_, &flags);
-            if (iface()->matching_node(nmsg()->src, NodeHandle(dst)))
+            if (!dst || matching_node(nmsg()->src, NodeHandle(dst)))
             {
-                ++nextConsistIndex_;
-                return again();
+                // Do not echo the command back to where it came from.
+                return false;
             }
             uint8_t cmd = payload()[0] & TractionDefs::REQ_MASK;
-            bool flip_speed = false;
-            if (cmd == TractionDefs::REQ_SET_SPEED) {
-                if (flags & TractionDefs::CNSTFLAGS_REVERSE) {
-                    flip_speed = true;
-                }
-            } else if (cmd == TractionDefs::REQ_SET_FN) {
+            if (cmd == TractionDefs::REQ_SET_FN)
+            {
                 uint32_t address = payload()[1];
                 address <<= 8;
                 address |= payload()[2];
                 address <<= 8;
                 address |= payload()[3];
-                if (address == 0) {
-                    if ((flags & TractionDefs::CNSTFLAGS_LINKF0) == 0) {
-                        // skip
-                        ++nextConsistIndex_;
-                        return again();
-                    }
-                } else {
-                    if ((flags & TractionDefs::CNSTFLAGS_LINKFN) == 0) {
-                        // skip
-                        ++nextConsistIndex_;
-                        return again();
-                    }
-                }
-            }
-            if (count == nextConsistIndex_ + 1u)
-            {
-                // last node: we can transfer the message.
-                auto *b = transfer_message();
-                b->data()->src = NodeHandle(train_node->node_id());
-                b->data()->dst = NodeHandle(dst);
-                b->data()->dstNode = nullptr;
-                if (flip_speed) {
-                    b->data()->payload[1] ^= 0x80;
+                if (address == 0)
+                {
+                    return (flags & TractionDefs::CNSTFLAGS_LINKF0) != 0;
                 }
-                b->data()->payload[0] |= TractionDefs::REQ_LISTENER;
-                iface()->addressed_message_write_flow()->send(b);
-                return exit();
+                return (flags & TractionDefs::CNSTFLAGS_LINKFN) != 0;
             }
-            else
+            return true;
+        }
+
+        /// Fills in a message to be forwarded to a consist member. Does not
+        /// access the incoming message, because that might have been
+        /// transferred already.
+        /// @param m the outgoing message, already containing the payload of
+        /// the incoming command.
+        /// @param src node ID of this train node.
+        /// @param dst node ID of the consist member.
+        /// @param flags consist flags of the member.
+        /// @param cmd the command byte of the incoming message.
+        void prepare_forward(
+            GenMessage *m, NodeID src, NodeID dst, uint8_t flags, uint8_t cmd)
+        {
+            m->src = NodeHandle(src);
+            m->dst = NodeHandle(dst);
+            m->dstNode = nullptr;
+            m->payload[0] |= TractionDefs::REQ_LISTENER;
+            if (cmd == TractionDefs::REQ_SET_SPEED &&
+                (flags & TractionDefs::CNSTFLAGS_REVERSE))
             {
-                return allocate_and_call(
-                    iface()->addressed_message_write_flow(),
-                    STATE(forward_consist));
+                m->payload[1] ^= 0x80;
             }
         }
 
-        Action forward_consist()
+        /// Forwards the incoming command to every consist member in one
+        /// burst. The members are copied from the incoming message, except
+        /// for the last one, which gets the incoming buffer itself.
+        Action maybe_forward_consist()
         {
-            auto *b =
-                get_allocation_result(iface()->addressed_message_write_flow());
-            uint8_t flags;
-            NodeID dst = train_node()->query_consist(nextConsistIndex_, &flags);
-            if (!dst)
+            auto *train_node = this->train_node();
+            int count = train_node->query_consist_length();
+            int last = -1;
+            uint8_t flags = 0;
+            for (int i = count - 1; i >= 0; --i)
+            {
+                NodeID dst = train_node->query_consist(i, &flags);
+                if (should_forward(dst, flags))
+                {
+                    last = i;
+                    break;
+                }
+            }
+            if (last < 0)
             {
-                // Strange. The consist destination should exist and never be
-                // zero once we got here.
-                b->unref();
                 return release_and_exit();
             }
-            b->data()->reset(message()->data()->mti, train_node()->node_id(),
-                             NodeHandle(dst), message()->data()->payload);
-            b->data()->payload[0] |= TractionDefs::REQ_LISTENER;
-            if (((payload()[0] & TractionDefs::REQ_MASK) ==
-                    TractionDefs::REQ_SET_SPEED) &&
-                (flags & TractionDefs::CNSTFLAGS_REVERSE))
+            uint8_t cmd = payload()[0] & TractionDefs::REQ_MASK;
+            NodeID src = train_node->node_id();
+            auto *write_flow = iface()->addressed_message_write_flow();
+            for (int i = 0; i < last; ++i)
             {
-                b->data()->payload[1] ^= 0x80;
+                NodeID dst = train_node->query_consist(i, &flags);
+                if (!should_forward(dst, flags))
+                {
+                    continue;
+                }
+                auto *b = write_flow->alloc();
+                b->data()->reset(
+                    nmsg()->mti, src, NodeHandle(dst), nmsg()->payload);
+                prepare_forward(b->data(), src, dst, flags, cmd);
+                write_flow->send(b);
             }
-            iface()->addressed_message_write_flow()->send(b);
-            ++nextConsistIndex_;
-            return call_immediately(STATE(maybe_forward_consist));
+            NodeID dst = train_node->query_consist(last, &flags);
+            auto *b = transfer_message();
+            prepare_forward(b->data(), src, dst, flags, cmd);
+            write_flow->send(b);
+            return exit();
         }
 
         Action handle_traction_mgmt()
@@ -650,7 +686,6 @@ struct TrainService::Impl
     private:
         /// error code for reject_permanent().
         unsigned errorCode_ : 16;
-        unsigned nextConsistIndex_ : 8;
         /// 1 if the voluntary lock protocol has set this train to be reserved.
         unsigned reserved_ : 1;
         TrainService *trainService_;
@@ -669,6 +704,15 @@ TrainService::TrainService(If *iface, NodeRegistry *train_node_registry)
     impl_ = new Impl(this);
 }
 
+TrainService::TrainService(
+    If *iface, ExecutorBase *executor, NodeRegistry *train_node_registry)
+    : Service(executor)
+    , iface_(iface)
+    , nodes_(train_node_registry)
+{
+    impl_ = new Impl(this);
+}
+
 TrainService::~TrainService()
 {
     delete impl_;
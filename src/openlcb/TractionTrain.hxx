@@ -36,6 +36,7 @@
 #define _OPENLCB_TRACTIONTRAIN_HXX_
 
 #include <set>
+#include <vector>
 
 #include "executor/Service.hxx"
 #include "openlcb/DefaultNodeRegistry.hxx"
@@ -128,9 +129,9 @@ public:
     virtual int query_consist_length() = 0;
 };
 
-/// Linked list entry for all registered consist clients for a given train
-/// node.
-struct ConsistEntry : public QMember
+/// Entry in the consist table of a given train node. Stores the node ID and
+/// the flags of one consist member packed into a single word.
+struct ConsistEntry
 {
     /// Creates a new consist entry storage.
     /// @param s the stored node ID
@@ -166,8 +167,6 @@ private:
 /// consist management functions.
 class TrainNodeWithConsist : public TrainNode {
 public:
-    ~TrainNodeWithConsist();
-
     /// @copydoc TrainNode::function_policy()
     /// The default function policy applies everything.
     bool function_policy(NodeHandle src, uint8_t command_byte, uint32_t fnum,
@@ -193,16 +192,15 @@ public:
         {
             return false;
         }
-        auto it = consistSlaves_.begin();
-        for (; it != consistSlaves_.end(); ++it)
+        for (auto &e : consistSlaves_)
         {
-            if (it->get_slave() == tgt)
+            if (e.get_slave() == tgt)
             {
-                it->set_flags(flags);
+                e.set_flags(flags);
                 return false;
             }
         }
-        consistSlaves_.insert(it, new ConsistEntry(tgt, flags));
+        consistSlaves_.emplace_back(tgt, flags);
         return true;
     }
 
@@ -214,9 +212,7 @@ public:
         {
             if (it->get_slave() == tgt)
             {
-                auto* p = it.operator->();
                 consistSlaves_.erase(it);
-                delete p;
                 return true;
             }
         }
@@ -227,31 +223,24 @@ public:
      * fewer than id consist targets. id is zero-based. */
     NodeID query_consist(int id, uint8_t* flags) override
     {
-        int k = 0;
-        for (auto it = consistSlaves_.begin();
-             it != consistSlaves_.end(); ++it, ++k)
+        if (id < 0 || (unsigned)id >= consistSlaves_.size())
         {
-            if (k == id)
-            {
-                if (flags) *flags = it->get_flags();
-                return it->get_slave();
-            }
+            return 0;
         }
-        return 0;
+        const ConsistEntry &e = consistSlaves_[id];
+        if (flags) *flags = e.get_flags();
+        return e.get_slave();
     }
 
     /** Returns the number of slaves in this consist. */
     int query_consist_length() override
     {
-        int ret = 0;
-        for (auto it = consistSlaves_.begin(); it != consistSlaves_.end();
-             ++it, ++ret)
-        {
-        }
-        return ret;
+        return consistSlaves_.size();
     }
 
-    TypedQueue<ConsistEntry> consistSlaves_;
+    /// Consist members in the order they were added. Indexed by the
+    /// zero-based consist link id.
+    std::vector<ConsistEntry> consistSlaves_;
 };
 
 /// Default implementation of a train node.
@@ -363,6 +352,17 @@ public:
     /// NodeRegistry. Ownership is transferred.
     TrainService(
         If *iface, NodeRegistry *train_node_registry = new DefaultNodeRegistry);
+
+    /// Constructor that runs the traction protocol on a separate executor
+    /// instead of the interface's executor, for example on a strand of an
+    /// ExecutorPool. The TrainImpl objects of the trains will be called on
+    /// that executor.
+    /// @param iface the OpenLCB interface to which the train nodes are bound.
+    /// @param executor where to run the traction request flow.
+    /// @param train_node_registry implementation of the
+    /// NodeRegistry. Ownership is transferred.
+    TrainService(If *iface, ExecutorBase *executor,
+        NodeRegistry *train_node_registry = new DefaultNodeRegistry);
     ~TrainService();
 
     If *iface()
@@ -39,7 +39,11 @@ DEFAULT_CONST(remote_alias_cache_size, 10);
 /** Number of entries in the local alias cache */
 DEFAULT_CONST(local_alias_cache_size, 3);
 
-/** Keep this many allocated but unused aliases around. */
+/** Keep this many allocated but unused aliases around. Values above 1 make
+ * the alias allocator keep a pool of reserved aliases that is refilled in
+ * bulk in the background, which allows bringing up many virtual nodes
+ * quickly. The local alias cache has to be large enough to hold these in
+ * addition to the local nodes' aliases. */
 DEFAULT_CONST(reserve_unused_alias_count, 0);
 
 /** Maximum number of local nodes */
@@ -71,6 +75,24 @@ DEFAULT_CONST_FALSE(enable_all_memory_space);
  * standard. */
 DEFAULT_CONST_TRUE(node_init_identify);
 
+/** Set to CONSTANT_TRUE to use the flat sorted-array event registry
+ * (FlatEventHandlers) instead of the tree. It is faster for nodes with many
+ * registered events, but needs a bit more memory. */
+DEFAULT_CONST_FALSE(flat_event_registry);
+
+/** Set to CONSTANT_TRUE to use hash tables instead of sorted arrays for the
+ * lookups in the remote alias cache of the CAN interface. This makes adding
+ * and removing entries O(1), which helps on large layouts, but takes 8-16
+ * bytes per entry instead of 4. */
+DEFAULT_CONST_FALSE(remote_alias_cache_hash_index);
+
+/** Set to CONSTANT_TRUE to keep a table of the local nodes indexed by alias
+ * in the CAN interface. This saves the alias cache and the node map lookups
+ * for incoming addressed messages, which helps with many virtual nodes (e.g.
+ * a command station with many train nodes), but takes 4096 pointers of
+ * RAM. */
+DEFAULT_CONST_FALSE(local_node_alias_index);
+
 /** How many CAN frames should the bulk alias allocator be sending at the same
  * time. */
 DEFAULT_CONST(bulk_alias_num_can_frames, 20);
@@ -78,3 +100,18 @@ DEFAULT_CONST(bulk_alias_num_can_frames, 20);
 /** Default number of bytes in maximum stream window size for { @ref
  * StreamReceiver }. */
 DEFAULT_CONST(stream_receiver_default_window_size, 2 * 1024);
+
+/** Milliseconds without incoming data after which a memory config write
+ * stream is rejected and its stream receiver released. */
+DEFAULT_CONST(stream_write_timeout_msec, 5000);
+
+/** Milliseconds per kilobyte of payload that a memory config client waits,
+ * after sending a write stream, for the remote node to write the data and
+ * send the Write Stream Reply. This is on top of a fixed 3 seconds. The
+ * default allows for a write speed of 1 kbyte/sec. */
+DEFAULT_CONST(stream_write_reply_msec_per_kb, 1000);
+
+/** Set to CONSTANT_TRUE to keep a write-back copy of the config file in RAM
+ * (see openlcb::ConfigCache). Config reads are then served from RAM and the
+ * writes are batched. Needs CONFIG_FILE_SIZE bytes of RAM. */
+DEFAULT_CONST_FALSE(cache_config_file);
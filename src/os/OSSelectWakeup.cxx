@@ -36,6 +36,17 @@
 #if defined(__MACH__)
 #define _DARWIN_C_SOURCE // pselect
 #endif
+#if OPENMRN_HAVE_EPOLL
+#include <atomic>
+#include <errno.h>
+#include <sys/epoll.h>
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 35)
+/// ::epoll_pwait2 takes the timeout in nanoseconds (Linux 5.11, glibc 2.35).
+#define OPENMRN_HAVE_EPOLL_PWAIT2 1
+#endif
+#endif
+#endif
 
 void empty_signal_handler(int)
 {
@@ -112,6 +123,59 @@ int OSSelectWakeup::select(int nfds, fd_set *readfds,
     return ret;
 }
 
+#if OPENMRN_HAVE_EPOLL
+int OSSelectWakeup::epoll_wait(int epfd, struct epoll_event *events,
+    int maxevents, long long deadline_nsec)
+{
+    {
+        AtomicHolder l(this);
+        inSelect_ = true;
+        if (pendingWakeup_)
+        {
+            deadline_nsec = 0;
+        }
+    }
+    int ret = -1;
+    bool waited = false;
+#if OPENMRN_HAVE_EPOLL_PWAIT2
+    // Set to false if the kernel is too old for epoll_pwait2.
+    static std::atomic<bool> have_pwait2 {true};
+    if (have_pwait2.load(std::memory_order_relaxed))
+    {
+        struct timespec timeout;
+        timeout.tv_sec = deadline_nsec / 1000000000LL;
+        timeout.tv_nsec = deadline_nsec % 1000000000LL;
+        ret = ::epoll_pwait2(epfd, events, maxevents,
+            deadline_nsec < 0 ? nullptr : &timeout, &origMask_);
+        if (ret >= 0 || errno != ENOSYS)
+        {
+            waited = true;
+        }
+        else
+        {
+            have_pwait2 = false;
+        }
+    }
+#endif
+    if (!waited)
+    {
+        // Rounds up, otherwise we would spin until a timer that is due in
+        // less than a millisecond expires. The timers thus fire up to a
+        // millisecond late.
+        int timeout_msec = deadline_nsec < 0
+            ? -1
+            : (int)((deadline_nsec + 999999) / 1000000);
+        ret = ::epoll_pwait(epfd, events, maxevents, timeout_msec, &origMask_);
+    }
+    {
+        AtomicHolder l(this);
+        pendingWakeup_ = false;
+        inSelect_ = false;
+    }
+    return ret;
+}
+#endif // OPENMRN_HAVE_EPOLL
+
 #ifdef ESP_PLATFORM
 #include "freertos_includes.h"
 
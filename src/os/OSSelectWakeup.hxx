@@ -68,6 +68,10 @@
 
 #endif // ESP_PLATFORM
 
+#if OPENMRN_HAVE_EPOLL
+struct epoll_event;
+#endif
+
 /// Signal handler that does nothing. @param sig ignored.
 void empty_signal_handler(int sig);
 
@@ -201,6 +205,25 @@ public:
     int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
                long long deadline_nsec);
 
+#if OPENMRN_HAVE_EPOLL
+    /** Portable call to epoll_wait that can be woken up asynchronously from a
+     * different thread.
+     *
+     * @param epfd is the epoll instance.
+     * @param events is as a regular ::epoll_wait call.
+     * @param maxevents is as a regular ::epoll_wait call.
+     * @param deadline_nsec is the maximum time to sleep if no fd activity and
+     * no wakeup happens. -1 to sleep indefinitely, 0 to return immediately.
+     * Rounded up to milliseconds if the system has no ::epoll_pwait2.
+     *
+     * @return what epoll_wait would return (number of events, 0 in case of
+     * timeout), or -1 and errno==EINTR if the wait was woken up
+     * asynchronously
+     */
+    int epoll_wait(int epfd, struct epoll_event *events, int maxevents,
+        long long deadline_nsec);
+#endif
+
 private:
 #ifdef ESP_PLATFORM
     void esp_allocate_vfs_fd();
@@ -34,6 +34,8 @@
 #include "utils/Buffer.hxx"
 #include "utils/ByteBuffer.hxx"
 
+#include "nmranet_config.h"
+
 DynamicPool *mainBufferPool = nullptr;
 Pool *rawBufferPool = nullptr;
 
@@ -47,6 +49,8 @@ Pool* init_main_buffer_pool()
     {
         mainBufferPool =
             new DynamicPool(Bucket::init(32, 48, LARGEST_BUFFERPOOL_BUCKET, 0));
+        mainBufferPool->enable_thread_cache(
+            config_buffer_pool_magazine_size());
     }
     return mainBufferPool;
 }
@@ -57,9 +61,10 @@ Pool* init_main_buffer_pool()
 size_t DynamicPool::free_items()
 {
     size_t total = 0;
-    for (Bucket *current = buckets; current->size() != 0; ++current)
+    unsigned idx = 0;
+    for (Bucket *current = buckets; current->size() != 0; ++current, ++idx)
     {
-        total += current->pending();
+        total += current->pending() + thread_cached_items(idx);
     }
     return total;
 }
@@ -70,11 +75,12 @@ size_t DynamicPool::free_items()
  */
 size_t DynamicPool::free_items(size_t size)
 {
-    for (Bucket *current = buckets; current->size() != 0; ++current)
+    unsigned idx = 0;
+    for (Bucket *current = buckets; current->size() != 0; ++current, ++idx)
     {
         if (current->size() >= size)
         {
-            return current->pending();
+            return current->pending() + thread_cached_items(idx);
         }
     }
     return 0;
@@ -96,6 +102,230 @@ extern "C" {
 extern void *buffer_malloc(size_t length);
 }
 
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+/// Number of buckets that have a magazine in the thread cache. Allocations
+/// from larger buckets always go to the shared bucket.
+static constexpr unsigned MAX_MAGAZINES = 4;
+
+/// Free items of one DynamicPool held by a thread. Only the owning thread
+/// touches the magazines, so they need no locking; the shared buckets are
+/// locked once per batch of items moved.
+struct DynamicPool::ThreadCache
+{
+    /// Returns the cached items to the pool when the thread exits.
+    ~ThreadCache()
+    {
+        if (pool_)
+        {
+            flush();
+        }
+    }
+
+    /// Takes a free item from a magazine, refilling it from the shared
+    /// bucket if empty.
+    /// @param idx bucket index
+    /// @return a free item, or nullptr if the shared bucket is empty too.
+    QMember *alloc(unsigned idx)
+    {
+        ++allocs_;
+        if (head_[idx])
+        {
+            ++hits_;
+            return pop(idx);
+        }
+        Bucket *bucket = pool_->buckets + idx;
+        {
+            AtomicHolder h(bucket->lock());
+            for (unsigned i = 0; i < pool_->magazineSize_; ++i)
+            {
+                QMember *item = bucket->next_locked().item;
+                if (!item)
+                {
+                    break;
+                }
+                push(idx, item);
+            }
+        }
+        publish();
+        return head_[idx] ? pop(idx) : nullptr;
+    }
+
+    /// Puts a released item into a magazine. Returns a batch of items to the
+    /// shared bucket if the magazine is too full.
+    /// @param idx bucket index
+    /// @param item released item
+    void free(unsigned idx, QMember *item)
+    {
+        push(idx, item);
+        if (count_[idx] > 2 * pool_->magazineSize_)
+        {
+            drain(idx, pool_->magazineSize_);
+            publish();
+        }
+    }
+
+    /// Returns all items to the shared buckets and detaches from the pool.
+    void flush()
+    {
+        for (unsigned idx = 0;
+             idx < MAX_MAGAZINES && pool_->buckets[idx].size() != 0; ++idx)
+        {
+            drain(idx, 0);
+        }
+        publish();
+        pool_ = nullptr;
+    }
+
+    /// Moves items from a magazine to the shared bucket.
+    /// @param idx bucket index
+    /// @param keep how many items to leave in the magazine
+    void drain(unsigned idx, unsigned keep)
+    {
+        Bucket *bucket = pool_->buckets + idx;
+        AtomicHolder h(bucket->lock());
+        while (count_[idx] > keep)
+        {
+            bucket->insert_locked(pop(idx));
+        }
+    }
+
+    /// Adds the local counters to the pool statistics.
+    void publish()
+    {
+        AtomicHolder h(pool_);
+        pool_->stats_.allocs += allocs_;
+        pool_->stats_.cacheHits += hits_;
+        allocs_ = 0;
+        hits_ = 0;
+    }
+
+    /// Adds an item to the front of a magazine.
+    void push(unsigned idx, QMember *item)
+    {
+        item->next = head_[idx];
+        head_[idx] = item;
+        ++count_[idx];
+    }
+
+    /// Removes the front item of a (non-empty) magazine.
+    QMember *pop(unsigned idx)
+    {
+        QMember *item = head_[idx];
+        head_[idx] = item->next;
+        item->next = nullptr;
+        --count_[idx];
+        return item;
+    }
+
+    /// Pool for which we hold items, nullptr if none yet.
+    DynamicPool *pool_ {nullptr};
+    /// Free items per bucket, linked through QMember::next.
+    QMember *head_[MAX_MAGAZINES] {};
+    /// Number of items in each magazine.
+    unsigned count_[MAX_MAGAZINES] {};
+    /// Allocations not yet added to the pool statistics.
+    unsigned allocs_ {0};
+    /// Cache hits not yet added to the pool statistics.
+    unsigned hits_ {0};
+};
+
+thread_local DynamicPool::ThreadCache DynamicPool::threadCache_;
+
+DynamicPool::ThreadCache *DynamicPool::thread_cache()
+{
+    if (!magazineSize_)
+    {
+        return nullptr;
+    }
+    ThreadCache *c = &threadCache_;
+    if (c->pool_ == this)
+    {
+        return c;
+    }
+    if (!c->pool_)
+    {
+        c->pool_ = this;
+        return c;
+    }
+    return nullptr;
+}
+#endif // OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+
+size_t DynamicPool::thread_cached_items(unsigned idx)
+{
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+    if (idx < MAX_MAGAZINES && threadCache_.pool_ == this)
+    {
+        return threadCache_.count_[idx];
+    }
+#endif
+    return 0;
+}
+
+void DynamicPool::enable_thread_cache(unsigned magazine_size)
+{
+    magazineSize_ = magazine_size;
+}
+
+void DynamicPool::flush_thread_cache()
+{
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+    if (threadCache_.pool_ == this)
+    {
+        threadCache_.flush();
+    }
+#endif
+}
+
+DynamicPool::Stats DynamicPool::stats()
+{
+    AtomicHolder h(this);
+    Stats ret = stats_;
+    for (Bucket *current = buckets; current->size() != 0; ++current)
+    {
+        ret.allocs += current->numAllocs_;
+    }
+    return ret;
+}
+
+void DynamicPool::add_total_size(size_t size)
+{
+    AtomicHolder h(this);
+    totalSize += size;
+    if (totalSize > stats_.highWaterSize)
+    {
+        stats_.highWaterSize = totalSize;
+    }
+}
+
+BufferBase *DynamicPool::alloc_from_bucket(Bucket *bucket, unsigned idx)
+{
+    QMember *item;
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+    ThreadCache *c = idx < MAX_MAGAZINES ? thread_cache() : nullptr;
+    if (c)
+    {
+        item = c->alloc(idx);
+    }
+    else
+#endif
+    {
+        AtomicHolder h(bucket->lock());
+        item = bucket->next_locked().item;
+        ++bucket->numAllocs_;
+    }
+    if (item)
+    {
+        return static_cast<BufferBase *>(item);
+    }
+    {
+        AtomicHolder h(this);
+        bucket->allocCount_++;
+    }
+    add_total_size(bucket->size());
+    return (BufferBase *)buffer_malloc(bucket->size());
+}
+
 /** Get a free item out of the pool.
  * @param size tells how much to allocate (in bytes)
  * @param flow if !NULL, then the alloc call is considered async and will
@@ -106,23 +336,12 @@ BufferBase *DynamicPool::alloc_untyped(size_t size, Executable *flow)
 {
     BufferBase *result = NULL;
 
-    for (Bucket *current = buckets; current->size() != 0; ++current)
+    unsigned idx = 0;
+    for (Bucket *current = buckets; current->size() != 0; ++current, ++idx)
     {
         if (size <= current->size())
         {
-            result = static_cast<BufferBase*>(current->next().item);
-            if (result == NULL)
-            {
-                result = (BufferBase*)buffer_malloc(current->size());
-                {
-                    AtomicHolder h(this);
-                    if (0 && totalSize < 5000 && totalSize + current->size() >= 5000) {
-                        HASSERT(0);
-                    }
-                    current->allocCount_++;
-                    totalSize += current->size();
-                }
-            }
+            result = alloc_from_bucket(current, idx);
             new (result) BufferBase(size, this);
             break;
         }
@@ -133,10 +352,7 @@ BufferBase *DynamicPool::alloc_untyped(size_t size, Executable *flow)
         /* big items are just malloc'd freely */
         result = (BufferBase*)alloc_large(size);
         new (result) BufferBase(size, this);
-        {
-            AtomicHolder h(this);
-            totalSize += size;
-        }
+        add_total_size(size);
     }
 #ifdef DEBUG_BUFFER_MEMORY
     {
@@ -170,10 +386,19 @@ void DynamicPool::free(BufferBase *item)
         g_alloc_source.erase(item);
     }
 #endif
-    for (Bucket *current = buckets; current->size() != 0; ++current)
+    unsigned idx = 0;
+    for (Bucket *current = buckets; current->size() != 0; ++current, ++idx)
     {
         if (item->size() <= current->size())
         {
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+            ThreadCache *c = idx < MAX_MAGAZINES ? thread_cache() : nullptr;
+            if (c)
+            {
+                c->free(idx, item);
+                return;
+            }
+#endif
             current->insert(item);
             return;
         }
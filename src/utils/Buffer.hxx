@@ -46,6 +46,7 @@
 
 #include "executor/Executable.hxx"
 #include "executor/Notifiable.hxx"
+#include "openmrn_features.h"
 #include "os/OS.hxx"
 #include "utils/Atomic.hxx"
 #include "utils/MultiMap.hxx"
@@ -473,6 +474,8 @@ private:
     size_t size_; /**< size of entry */
 public:
     size_t allocCount_{0}; /**< total entries allocated */
+    /** entries taken from the bucket bypassing the thread cache */
+    uint64_t numAllocs_{0};
 private:
     /** list of anyone waiting for an item in the bucket */
     Q pending_;
@@ -496,6 +499,7 @@ public:
     /** default destructor */
     ~DynamicPool()
     {
+        flush_thread_cache();
 #ifdef GTEST
         for (unsigned i = 0; buckets[i].size() != 0; ++i)
         {
@@ -514,7 +518,8 @@ public:
         Bucket::destroy(buckets);
     }
 
-    /** Number of free items in the pool.
+    /** Number of free items in the pool. Includes the items in the
+     * magazines of the calling thread, but not those of other threads.
      * @return number of free items in the pool
      */
     size_t free_items() override;
@@ -525,11 +530,70 @@ public:
      */
     size_t free_items(size_t size) override;
 
+    /** Turns on the per-thread magazines. Each thread will keep up to
+     * 2*magazine_size free items per bucket for itself, and refills or
+     * returns them magazine_size at a time from/to the shared buckets. A
+     * thread caches items for only one pool; allocations from other pools
+     * use the shared buckets. All threads that used this pool must have
+     * exited or called flush_thread_cache() before the pool is destroyed.
+     * No-op unless OPENMRN_FEATURE_BUFFER_THREAD_CACHE is set.
+     * @param magazine_size number of items moved in one refill; 0 disables
+     * the magazines for allocations after this call.
+     */
+    void enable_thread_cache(unsigned magazine_size);
+
+    /** Returns the free items held by the calling thread for this pool into
+     * the shared buckets, and publishes the thread's statistics. */
+    void flush_thread_cache();
+
+    /** Allocation statistics. The thread-local counters are added lazily
+     * when a thread refills or returns a magazine, or calls
+     * flush_thread_cache(). */
+    struct Stats
+    {
+        /// Number of items allocated from the buckets.
+        uint64_t allocs;
+        /// How many of these were served from a thread magazine without
+        /// touching the shared bucket.
+        uint64_t cacheHits;
+        /// Largest value total_size() ever had.
+        size_t highWaterSize;
+    };
+
+    /** @return a snapshot of the allocation statistics. */
+    Stats stats();
+
 protected:
     /** Free buffer queue */
     Bucket *buckets;
 
 private:
+#if OPENMRN_FEATURE_BUFFER_THREAD_CACHE
+    /** Free items held by one thread. Defined in Buffer.cxx. */
+    struct ThreadCache;
+    /** Magazines of the calling thread. */
+    static thread_local ThreadCache threadCache_;
+
+    /** @return the magazines of the calling thread if they are used for
+     * this pool, otherwise nullptr. */
+    ThreadCache *thread_cache();
+#endif
+
+    /** Takes one free item from a bucket or from the thread cache, or
+     * allocates a new one from the heap.
+     * @param bucket the bucket to allocate from
+     * @param idx index of bucket in the buckets array
+     * @return memory for the buffer (not constructed) */
+    BufferBase *alloc_from_bucket(Bucket *bucket, unsigned idx);
+
+    /** @return how many free items of a bucket the calling thread holds in
+     * its magazine for this pool. @param idx index of the bucket. */
+    size_t thread_cached_items(unsigned idx);
+
+    /** Adds a buffer size to the total allocated size. @param size bytes
+     * newly allocated from the heap. */
+    void add_total_size(size_t size);
+
     /** Get a free item out of the pool.
      * @param result pointer to a pointer to the result
      * @param flow if !NULL, then the alloc call is considered async and will
@@ -556,6 +620,11 @@ private:
      */
     DynamicPool();
 
+    /** Number of items in one magazine refill, 0 if thread caching is off. */
+    unsigned magazineSize_ {0};
+    /** Published statistics, protected by the Atomic. */
+    Stats stats_ {0, 0, 0};
+
     friend class ForwardAllocator;
 
     DISALLOW_COPY_AND_ASSIGN(DynamicPool);
@@ -0,0 +1,147 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file CanHubShards.cxx
+ * Splits the ports of a CAN hub across a pool of worker executors.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#include "utils/CanHubShards.hxx"
+
+#include "executor/Executor.hxx"
+#include "executor/Service.hxx"
+#include "utils/StringPrintf.hxx"
+
+/// Hub port that forwards every packet to another hub, marking the packet as
+/// coming from the peer port registered on that other hub.
+class CanHubShards::BridgePort : public CanHubPortInterface
+{
+public:
+    /// Constructor.
+    ///
+    /// @param target the hub to forward the packets to.
+    BridgePort(CanHubFlow *target)
+        : target_(target)
+    {
+    }
+
+    /// @param peer the port on the target hub that belongs to the same
+    /// bridge. Packets are forwarded with this skip member to avoid loopback.
+    void set_peer(CanHubPortInterface *peer)
+    {
+        peer_ = peer;
+    }
+
+    void send(Buffer<CanHubData> *b, unsigned priority) override
+    {
+        if (b->references() > 1)
+        {
+            // The payload is shared with other ports; we need our own copy
+            // for changing the skip member.
+            Buffer<CanHubData> *c = target_->alloc();
+            *c->data()->mutable_frame() = b->data()->frame();
+            b->unref();
+            b = c;
+        }
+        b->data()->skipMember_ = peer_;
+        target_->send(b, priority);
+    }
+
+private:
+    /// Where to forward the packets to.
+    CanHubFlow *target_;
+    /// Skip member to put into the forwarded packets.
+    CanHubPortInterface *peer_{nullptr};
+};
+
+/// One worker executor with its own hub, bridged to the parent hub.
+struct CanHubShards::Shard
+{
+    /// Constructor.
+    ///
+    /// @param parent the hub to bridge this shard to.
+    /// @param index the shard number, used for naming the thread.
+    Shard(CanHubFlow *parent, unsigned index)
+        : name_(StringPrintf("hub_shard%u", index))
+        , executor_(name_.c_str(), 0, 0)
+        , service_(&executor_)
+        , hub_(&service_)
+        , parent_(parent)
+        , up_(parent)
+        , down_(&hub_)
+    {
+        up_.set_peer(&down_);
+        down_.set_peer(&up_);
+        hub_.register_port(&up_);
+        parent_->register_port(&down_);
+    }
+
+    ~Shard()
+    {
+        parent_->unregister_port(&down_);
+        hub_.unregister_port(&up_);
+        // Flushes packets that are being delivered to the bridge ports.
+        parent_->service()->executor()->sync_run([]() {});
+        executor_.sync_run([]() {});
+    }
+
+    /// Name of the executor thread.
+    string name_;
+    /// Worker thread.
+    Executor<1> executor_;
+    /// Service for the worker thread.
+    Service service_;
+    /// The shard-local hub.
+    CanHubFlow hub_;
+    /// The hub this shard is attached to.
+    CanHubFlow *parent_;
+    /// Registered on the shard hub, forwards to the parent hub.
+    BridgePort up_;
+    /// Registered on the parent hub, forwards to the shard hub.
+    BridgePort down_;
+};
+
+CanHubShards::CanHubShards(CanHubFlow *parent, unsigned num_shards)
+    : parent_(parent)
+{
+    HASSERT(num_shards > 0);
+    for (unsigned i = 0; i < num_shards; ++i)
+    {
+        shards_.emplace_back(new Shard(parent_, i));
+    }
+}
+
+CanHubShards::~CanHubShards()
+{
+}
+
+CanHubFlow *CanHubShards::shard(unsigned i)
+{
+    HASSERT(i < shards_.size());
+    return &shards_[i]->hub_;
+}
@@ -0,0 +1,99 @@
+/** \copyright
+ * Copyright (c) 2026, Balazs Racz
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are  permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * \file CanHubShards.hxx
+ * Splits the ports of a CAN hub across a pool of worker executors.
+ *
+ * @author Balazs Racz
+ * @date 16 Oct 2026
+ */
+
+#ifndef _UTILS_CANHUBSHARDS_HXX_
+#define _UTILS_CANHUBSHARDS_HXX_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "utils/Hub.hxx"
+
+/// Runs the ports of a CAN hub on a pool of worker executors.
+///
+/// Each shard owns an executor thread and a CanHubFlow running on it. The
+/// shard hub is bridged to the parent hub by a pair of ports, so every packet
+/// entering any shard reaches the parent hub and all other shards, without
+/// loopback. Ports that are attached to a shard hub (e.g. gridconnect TCP
+/// clients) do all their parsing, formatting and socket I/O on the shard's
+/// executor; the parent hub's executor only routes packets between the
+/// shards and the ports attached directly to it.
+///
+/// Packets cross between shards through the thread-safe queue of the
+/// destination hub flow.
+class CanHubShards
+{
+public:
+    /// Constructor. Starts the worker threads.
+    ///
+    /// @param parent the CAN hub to attach the shards to.
+    /// @param num_shards how many worker executors to create. Must be > 0.
+    CanHubShards(CanHubFlow *parent, unsigned num_shards);
+
+    /// Destructor. Must not be called on the parent's or any of the shards'
+    /// executor. All ports that were registered to the shard hubs have to be
+    /// removed before.
+    ~CanHubShards();
+
+    /// @return the number of shards.
+    unsigned size()
+    {
+        return shards_.size();
+    }
+
+    /// @param i shard index, 0 <= i < size().
+    /// @return the hub of the given shard.
+    CanHubFlow *shard(unsigned i);
+
+    /// Assigns shards to new ports in a round-robin fashion. Thread-safe.
+    ///
+    /// @return the hub of the shard that the next port should be attached to.
+    CanHubFlow *next_shard()
+    {
+        return shard(nextShard_.fetch_add(1) % size());
+    }
+
+private:
+    class BridgePort;
+    struct Shard;
+
+    /// Hub that the shards are attached to.
+    CanHubFlow *parent_;
+    /// Owned shard objects.
+    std::vector<std::unique_ptr<Shard>> shards_;
+    /// Round-robin counter for next_shard().
+    std::atomic<unsigned> nextShard_{0};
+};
+
+#endif // _UTILS_CANHUBSHARDS_HXX_
@@ -101,6 +101,11 @@ public:
 
 /// Implementation of ConfigUpdateListener that registers itself in the
 /// constructor and unregisters itself in the destructor.
+///
+/// The registration happens in the base class constructor, so the object must
+/// be constructed either before the config update service's executor starts
+/// running or on that executor's thread. Otherwise the initial load may call
+/// into the object before the derived class constructor has completed.
 class DefaultConfigUpdateListener : public ConfigUpdateListener
 {
 public:
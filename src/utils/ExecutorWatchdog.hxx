@@ -35,13 +35,15 @@
 #ifndef _UTILS_EXECUTORWATCHDOG_HXX_
 #define _UTILS_EXECUTORWATCHDOG_HXX_
 
+#include "executor/ExecutorProfiler.hxx"
 #include "executor/StateFlow.hxx"
 #include "os/os.h"
 #include "utils/logging.h"
 
 /// This stateflow checks an executor every 50 msec. If the latency of a wakeup
 /// is more than 50 msec, then prints a warning of how long the executor was
-/// blocked.
+/// blocked. If the executor has a profiler, the warning also names the
+/// executable that ran the longest in that period.
 class ExecutorWatchdog : public StateFlowBase
 {
 public:
@@ -56,6 +58,14 @@ public:
 private:
     Action take_stamp()
     {
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+        auto *profiler = service()->executor()->profiler();
+        if (profiler)
+        {
+            // Starts tracking the longest run for the next period.
+            profiler->clear_slowest();
+        }
+#endif
         lastTimeMsec_ = NSEC_TO_MSEC(os_get_time_monotonic());
         return sleep_and_call(&timer_, MSEC_TO_NSEC(50), STATE(woken));
     }
@@ -68,6 +78,16 @@ private:
         {
             LOG(WARNING, "[WARN] Executor was blocked for %d msec",
                 (int)(diff - 50));
+#if OPENMRN_FEATURE_EXECUTOR_PROFILING
+            std::string name;
+            uint32_t usec;
+            auto *profiler = service()->executor()->profiler();
+            if (profiler && profiler->take_slowest(&name, &usec))
+            {
+                LOG(WARNING, "[WARN] Longest run: %s, %u usec", name.c_str(),
+                    (unsigned)usec);
+            }
+#endif
         }
         if (++count_ > (5000 / 50))
         {
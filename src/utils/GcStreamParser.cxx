@@ -32,10 +32,12 @@
  * @date 26 May 2016
  */
 
+#include <string.h>
 #include <string>
 
 #include "utils/GcStreamParser.hxx"
 #include "utils/gc_format.h"
+#include "can_frame.h"
 
 bool GcStreamParser::consume_byte(char c)
 {
@@ -75,6 +77,61 @@ bool GcStreamParser::consume_byte(char c)
     return false;
 }
 
+unsigned GcStreamParser::consume_frames(const char **data, size_t *len,
+    struct can_frame *frames, unsigned max_frames)
+{
+    const char *p = *data;
+    const char *end = p + *len;
+    unsigned count = 0;
+    while (count < max_frames && p < end)
+    {
+        if (offset_ >= 0)
+        {
+            // Finishes a frame that started in an earlier block.
+            if (consume_byte(*p++) && parse_frame_to_output(frames + count))
+            {
+                ++count;
+            }
+            continue;
+        }
+        const char *start = (const char *)memchr(p, ':', end - p);
+        if (!start)
+        {
+            // Drops everything -- we're not in the middle of a packet.
+            p = end;
+            break;
+        }
+        const char *stop = gc_format_find_delimiter(start + 1, end);
+        if (!stop)
+        {
+            // The frame continues in the next block.
+            consume_byte(*start);
+            p = start + 1;
+            continue;
+        }
+        if (*stop == ':')
+        {
+            // Frame restarts.
+            p = stop;
+            continue;
+        }
+        p = stop + 1;
+        size_t frame_len = stop - start - 1;
+        if (frame_len >= sizeof(cbuf_))
+        {
+            // Would have overrun the frame buffer.
+            continue;
+        }
+        if (gc_format_parse_len(start + 1, frame_len, frames + count) == 0)
+        {
+            ++count;
+        }
+    }
+    *len -= p - *data;
+    *data = p;
+    return count;
+}
+
 void GcStreamParser::frame_buffer(std::string* payload) {
     if (offset_ >= 0) {
         payload->assign(cbuf_, offset_);
@@ -66,6 +66,25 @@ public:
      * the frame is set to an error frame. */
     bool parse_frame_to_output(struct can_frame *output_frame);
 
+    /** Consumes a block of characters from the source stream and parses
+     * every complete frame in it. The result is the same as calling
+     * consume_byte() for each character and parse_frame_to_output() for each
+     * complete frame, but the frame boundaries are searched for several
+     * characters at a time, and frames that are entirely inside the block are
+     * parsed in place without copying them to the frame buffer. Frames with a
+     * parse error are dropped.
+     *
+     * @param data points to the characters to consume. Will be advanced past
+     * the consumed characters.
+     * @param len is the number of characters at data. Will be decreased by
+     * the number of consumed characters.
+     * @param frames is the output array for the parsed frames.
+     * @param max_frames is the size of the output array. Consuming stops
+     * after this many frames, leaving the rest of the characters in data.
+     * @return the number of frames written to frames. */
+    unsigned consume_frames(const char **data, size_t *len,
+        struct can_frame *frames, unsigned max_frames);
+
     /** @param payload fills with the current contents of the frame buffer. */
     void frame_buffer(std::string *payload);
 
@@ -37,6 +37,7 @@
 #include <sys/socket.h>
 
 #include "nmranet_config.h"
+#include "utils/CanHubShards.hxx"
 #include "utils/GridConnectHub.hxx"
 #include "utils/FdUtils.hxx"
 
@@ -50,7 +51,8 @@ void GcTcpHub::on_new_connection(int fd)
     }
     // Applies kernel parameters like socket options.
     FdUtils::optimize_socket_fd(fd);
-    create_gc_port_for_can_hub(canHub_, fd, this, use_select);
+    CanHubFlow *hub = shards_ ? shards_->next_shard() : canHub_;
+    create_gc_port_for_can_hub(hub, fd, this, use_select);
 }
 
 void GcTcpHub::notify()
@@ -70,6 +72,15 @@ GcTcpHub::GcTcpHub(CanHubFlow *can_hub, int port)
 {
 }
 
+GcTcpHub::GcTcpHub(CanHubShards *shards, int port)
+    : canHub_(nullptr)
+    , shards_(shards)
+    , tcpListener_(port,
+          std::bind(&GcTcpHub::on_new_connection, this, std::placeholders::_1),
+          "GcTcpHub")
+{
+}
+
 GcTcpHub::~GcTcpHub()
 {
     tcpListener_.shutdown();
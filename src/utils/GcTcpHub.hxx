@@ -38,6 +38,7 @@
 #include "utils/Hub.hxx"
 
 class ExecutorBase;
+class CanHubShards;
 
 /** This class runs a CAN-bus HUB listening on TCP socket using the gridconnect
  * format. Any new incoming connection will be wired into the same virtual CAN
@@ -52,6 +53,15 @@ public:
     /// onto.
     /// @param port TCp port number to listen on.
     GcTcpHub(CanHubFlow *can_hub, int port);
+
+    /// Constructor. Incoming connections will be distributed among the shards
+    /// in a round-robin fashion, and each connection's processing will happen
+    /// on the executor of its shard.
+    ///
+    /// @param shards set of CAN hub shards to attach the TCP gridconnect
+    /// clients to.
+    /// @param port TCp port number to listen on.
+    GcTcpHub(CanHubShards *shards, int port);
     ~GcTcpHub();
 
     /// @return true of the listener is ready to accept incoming connections.
@@ -80,6 +90,9 @@ private:
     /// @param can_hub Which CAN-hub should we attach the TCP gridconnect hub
     /// onto.
     CanHubFlow *canHub_;
+    /// If not null, new clients are attached to one of these shards instead
+    /// of canHub_.
+    CanHubShards *shards_ {nullptr};
     /// How many clients are connected right now.
     unsigned numClients_ {0};
     /// Helper object representing the listening on the socket.
@@ -61,9 +61,15 @@ public:
     /// @param can_side A hub of type struct can_frame, the binary side.
     /// @param double_bytes if true, upon rendering data each byte will be
     /// doubled. This is an anciant workaround.
-    GCAdapter(HubFlow *gc_side, CanHubFlow *can_side, bool double_bytes)
+    /// @param buffer_output if true, the outgoing gridconnect data is
+    /// collected for a short delay into larger buffers. If false, each frame
+    /// is sent in a separate buffer; use this when the port writing the data
+    /// does its own coalescing (e.g. HubDeviceSelect).
+    GCAdapter(HubFlow *gc_side, CanHubFlow *can_side, bool double_bytes,
+        bool buffer_output = true)
         : parser_(can_side->service(), can_side, &formatter_)
-        , formatter_(can_side->service(), gc_side, &parser_, double_bytes)
+        , formatter_(can_side->service(), gc_side, &parser_, double_bytes,
+              buffer_output)
     {
         gc_side->register_port(&parser_);
         can_side->register_port(&formatter_);
@@ -127,8 +133,10 @@ public:
         /// packets to.
         /// @param double_bytes if true, upon rendering data each byte will be
         /// doubled. This is an anciant workaround.
+        /// @param buffer_output if false, frames are sent to the destination
+        /// directly instead of the delay port.
         BinaryToGCMember(Service *service, HubFlow *destination,
-            HubPort *skip_member, int double_bytes)
+            HubPort *skip_member, int double_bytes, bool buffer_output = true)
             : CanHubPort(service)
             , delayPort_(service, destination, config_gridconnect_buffer_size(),
                   USEC_TO_NSEC(config_gridconnect_buffer_delay_usec()))
@@ -136,6 +144,10 @@ public:
             , skipMember_(skip_member)
             , double_bytes_(double_bytes)
         {
+            if (!buffer_output)
+            {
+                window_.reset(new OutputWindow(this));
+            }
             const int cnt = config_gridconnect_bridge_max_outgoing_packets();
             if (cnt > 1)
             {
@@ -166,7 +178,8 @@ public:
             {
                 state_pool = (int(ownedPool_->free_items()) == cnt);
             }
-            return state_delay && state_pool;
+            bool state_window = !window_ || window_->is_idle();
+            return state_delay && state_pool && state_window;
         }
 
         /// The dispatcher will be using this pool to allocate frames when a
@@ -180,6 +193,12 @@ public:
         {
             LOG(VERBOSE, "can packet arrived: %" PRIx32,
                 GET_CAN_FRAME_ID_EFF(*message()->data()));
+            BarrierNotifiable *done = nullptr;
+            if (window_ && !(done = window_->try_acquire()))
+            {
+                // Too many frames waiting to be written out.
+                return wait_and_call(STATE(entry));
+            }
             char *end =
                 gc_format_generate(message()->data(), dbuf_, double_bytes_);
             size_t size = (end - dbuf_);
@@ -193,6 +212,14 @@ public:
                 /// performance.
                 target_buffer->data()->resize(size);
                 memcpy((char *)target_buffer->data()->data(), dbuf_, size);
+                if (done)
+                {
+                    // The window gets notified when the data is written, so
+                    // we can continue with the next frame right away.
+                    target_buffer->set_done(done);
+                    destination_->send(target_buffer, 0);
+                    return release_and_exit();
+                }
                 target_buffer->set_done(bn_.reset(this));
                 delayPort_.send(target_buffer, 0);
                 release();
@@ -202,6 +229,10 @@ public:
             {
                 LOG(INFO, "gc generate failed.");
             }
+            if (done)
+            {
+                done->notify();
+            }
             return release_and_exit();
         }
 
@@ -211,6 +242,79 @@ public:
         }
 
     private:
+        /// Flow control for the frames sent directly to the destination.
+        /// Each frame gets a barrier from a fixed set; when all of them are
+        /// taken, the parent flow waits until one of the frames is written
+        /// out.
+        class OutputWindow : public Notifiable, private Atomic
+        {
+        public:
+            /// Constructor. @param parent flow to wake up when there is
+            /// space in the window.
+            OutputWindow(StateFlowBase *parent)
+                : parent_(parent)
+            {
+            }
+
+            /// Takes one slot in the window.
+            /// @return the barrier to use as the done notifiable of the
+            /// outgoing buffer, or nullptr if the window is full. In the
+            /// latter case the parent will be notified when a slot frees up.
+            BarrierNotifiable *try_acquire()
+            {
+                AtomicHolder h(this);
+                for (BarrierNotifiable &b : slots_)
+                {
+                    if (b.is_done())
+                    {
+                        return b.reset(this);
+                    }
+                }
+                waiting_ = true;
+                return nullptr;
+            }
+
+            /// Called when an output buffer is released.
+            void notify() override
+            {
+                bool wakeup;
+                {
+                    AtomicHolder h(this);
+                    wakeup = waiting_;
+                    waiting_ = false;
+                }
+                if (wakeup)
+                {
+                    parent_->notify();
+                }
+            }
+
+            /// @return true if no frames are outstanding.
+            bool is_idle()
+            {
+                AtomicHolder h(this);
+                for (BarrierNotifiable &b : slots_)
+                {
+                    if (!b.is_done())
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+        private:
+            /// How many frames can be waiting for the write. This is enough
+            /// to fill up one writev call of HubDeviceSelect.
+            static constexpr unsigned WINDOW_SIZE = 16;
+            /// Flow to wake up.
+            StateFlowBase *parent_;
+            /// true if the parent is waiting for a free slot.
+            bool waiting_ {false};
+            /// One barrier for each outstanding frame.
+            BarrierNotifiable slots_[WINDOW_SIZE];
+        };
+
         /// Helper class that assembles larger outgoing packets from the
         /// individual packets by delaying data a little bit.
         BufferPort delayPort_;
@@ -228,6 +332,9 @@ public:
         int double_bytes_;
         /// Helper object
         BarrierNotifiable bn_;
+        /// Flow control for the frames bypassing delayPort_. nullptr if the
+        /// output is buffered.
+        std::unique_ptr<OutputWindow> window_;
     };
 
     /// HubPort (on a string hub) that turns a gridconnect-formatted CAN packet
@@ -288,45 +395,85 @@ public:
         }
 
         /// Matches the incoming characters to the pattern to form incoming
-        /// frames. @return next state.
+        /// frames. All complete frames in the incoming data are parsed and
+        /// sent off in one go, as long as there are free output buffers.
+        /// @return next state.
         Action parse_more_data()
         {
-            while (inBufSize_--)
+            while (inBufSize_)
             {
-                char c = *inBuf_++;
-                if (streamSegmenter_.consume_byte(c))
+                unsigned max_frames = MAX_BATCH;
+                if (frameAllocator_)
+                {
+                    size_t free_frames = frameAllocator_->free_items();
+                    if (free_frames == 0)
+                    {
+                        // Out of buffers. Parses one frame and waits for a
+                        // buffer to be freed.
+                        if (streamSegmenter_.consume_frames(
+                                &inBuf_, &inBufSize_, &pendingFrame_, 1))
+                        {
+                            return allocate_and_call(destination_,
+                                STATE(send_pending_frame),
+                                frameAllocator_.get());
+                        }
+                        break;
+                    }
+                    if (free_frames < max_frames)
+                    {
+                        max_frames = free_frames;
+                    }
+                }
+                struct can_frame frames[MAX_BATCH];
+                unsigned count = streamSegmenter_.consume_frames(
+                    &inBuf_, &inBufSize_, frames, max_frames);
+                Buffer<CanHubData> *bufs[MAX_BATCH];
+                if (frameAllocator_)
+                {
+                    // Only this flow allocates from this pool, so the buffers
+                    // we saw free are still there.
+                    unsigned allocated =
+                        frameAllocator_->alloc_bulk(bufs, count);
+                    HASSERT(allocated == count);
+                }
+                else
+                {
+                    for (unsigned i = 0; i < count; ++i)
+                    {
+                        bufs[i] = destination_->alloc();
+                    }
+                }
+                for (unsigned i = 0; i < count; ++i)
                 {
-                    // End of frame. Allocate an output buffer and parse the
-                    // frame.
-                    return allocate_and_call(destination_, STATE(parse_to_output_frame), frameAllocator_.get());
+                    *bufs[i]->data()->mutable_frame() = frames[i];
+                    bufs[i]->data()->skipMember_ = skipMember_;
+                    destination_->send(bufs[i]);
                 }
             }
             // Will notify the caller.
             return release_and_exit();
         }
 
-        /** Takes the completed frame in cbuf_, parses it into the allocation
-         * result (a can pipe buffer) and sends off frame. Then comes back to
-         * process buffer. @return next state. */
-        Action parse_to_output_frame()
+        /** Copies the frame that was waiting for an output buffer into the
+         * allocation result (a can pipe buffer) and sends it off. Then comes
+         * back to process buffer. @return next state. */
+        Action send_pending_frame()
         {
-            auto* b = get_allocation_result(destination_);
-            if (streamSegmenter_.parse_frame_to_output(b->data()))
-            {
-                b->data()->skipMember_ = skipMember_;
-                destination_->send(b);
-            }
-            else
-            {
-                // Releases the buffer.
-                b->unref();
-            }
+            auto *b = get_allocation_result(destination_);
+            *b->data()->mutable_frame() = pendingFrame_;
+            b->data()->skipMember_ = skipMember_;
+            destination_->send(b);
             return call_immediately(STATE(parse_more_data));
         }
 
     private:
+        /// How many frames to parse and send in one batch.
+        static constexpr unsigned MAX_BATCH = 8;
+
         /// Holds the state of the incoming characters and the boundary.
         GcStreamParser streamSegmenter_;
+        /// Parsed frame waiting for an output buffer.
+        struct can_frame pendingFrame_;
         
         /// The incoming characters.
         const char *inBuf_;
@@ -433,6 +580,20 @@ GcPacketPrinter::~GcPacketPrinter()
 {
 }
 
+/// @return true if the gridconnect bridge should collect the output data into
+/// larger buffers before sending it to the port.
+/// @param use_select true if the port will be a HubDeviceSelect.
+static bool need_output_buffering(bool use_select)
+{
+#ifdef OPENMRN_HAVE_WRITEV
+    // The select-based device coalesces the writes by itself using writev,
+    // without copying the data and without a fixed delay.
+    return !use_select;
+#else
+    return true;
+#endif
+}
+
 /// Implementation class that adds a device to a CAN hub with dynamic
 /// translation of the packets to/from GridConnect format.
 ///
@@ -450,8 +611,8 @@ struct GcHubPort : public Executable
     /// are needed.
     GcHubPort(CanHubFlow *can_hub, int fd, Notifiable *on_exit, bool use_select)
         : gcHub_(can_hub->service())
-        , bridge_(
-              GCAdapterBase::CreateGridConnectAdapter(&gcHub_, can_hub, false))
+        , bridge_(new GCAdapter(
+              &gcHub_, can_hub, false, need_output_buffering(use_select)))
         , onExit_(on_exit)
     {
         LOG(VERBOSE, "gchub port %p", (Executable *)this);
@@ -176,6 +176,23 @@ public:
         this->unregister_handler(port, reinterpret_cast<uintptr_t>(port),
                                  POINTER_MASK);
     }
+
+    /// Turns on or off sharing the payload among the ports. By default every
+    /// port gets a separate copy of each message, allocated from the port's
+    /// pool(). When sharing is on, the incoming buffer is sent to all ports
+    /// with an added reference instead; no allocation or copy happens. The
+    /// port to skip is determined when the message enters the hub.
+    ///
+    /// Every port of a sharing hub must treat the incoming buffers as
+    /// read-only, including the skipMember_ field; a port that wants to
+    /// forward a message to a different hub has to make a copy. The ports'
+    /// pool() is not used, so it cannot throttle the hub.
+    ///
+    /// @param enabled true to share payloads, false to copy them.
+    void set_shared_payload(bool enabled)
+    {
+        this->shareMessage_ = enabled;
+    }
 };
 
 /** A generic hub that proxies packets of untyped (aka string) data. */
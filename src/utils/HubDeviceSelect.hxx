@@ -43,6 +43,20 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <fcntl.h>
+#ifdef OPENMRN_HAVE_WRITEV
+#include <sys/uio.h>
+/// One buffer of a gather write.
+typedef struct iovec HubIoVec;
+#else
+/// One buffer of a gather write. Has the same fields as struct iovec, which
+/// some platforms without writev define with a different layout or not at
+/// all.
+struct HubIoVec
+{
+    void *iov_base; ///< start of the data
+    size_t iov_len; ///< length of the data
+};
+#endif
 
 #include "executor/StateFlow.hxx"
 #include "utils/Hub.hxx"
@@ -323,7 +337,7 @@ public:
     /// @param on_error notifiable that will be called when a write or read
     /// error is encountered.
     HubDeviceSelect(HFlow *hub, int fd, Notifiable *on_error = nullptr)
-        : FdHubPortService(hub->service()->executor(), fd)
+        : FdHubPortService(hub->service()->executor(), set_nonblocking(fd))
         , hub_(hub)
         , readFlow_(this, hub, &writeFlow_)
         , writeFlow_(this)
@@ -332,12 +346,6 @@ public:
         barrier_.reset(
             on_error ? on_error : EmptyNotifiable::DefaultInstance());
         barrier_.new_child();
-#ifdef __WINNT__
-        unsigned long par = 1;
-        ioctlsocket(fd_, FIONBIO, &par);
-#else
-        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
-#endif
         hub_->register_port(write_port());
     }
 
@@ -399,15 +407,43 @@ public:
     }
 
 protected:
+    /// Puts a file descriptor into non-blocking mode. This has to happen
+    /// before the read flow is constructed, because the read flow may start
+    /// running on the executor thread right away.
+    /// @param fd file descriptor to modify.
+    /// @return fd.
+    static int set_nonblocking(int fd)
+    {
+#ifdef __WINNT__
+        unsigned long par = 1;
+        ioctlsocket(fd, FIONBIO, &par);
+#else
+        ::fcntl(fd, F_SETFL, O_RDWR | O_NONBLOCK);
+#endif
+        return fd;
+    }
+
     /// Base stateflow for the WriteFlow.
     typedef StateFlow<typename HFlow::buffer_type, QList<1>> WriteFlowBase;
     /// State flow implementing select-aware fd writes.
+    ///
+    /// The buffers waiting in the queue are written out together using one
+    /// writev call, without copying the data. There is no fixed delay for
+    /// collecting data: when the queue is short, the data is written out
+    /// immediately. When the measured batch sizes show that the data comes
+    /// in faster than one buffer per write, or the fd was not writable
+    /// recently, the flow yields once to the executor before the write, so
+    /// that the flows producing data can add more to the queue.
     class WriteFlow : public WriteFlowBase
     {
     public:
         /// Constructor. @param dev is the parent object.
         WriteFlow(HubDeviceSelect *dev)
             : WriteFlowBase(dev)
+            , avgBatch_(BATCH_ONE)
+            , batchSize_(0)
+            , iovHead_(0)
+            , blocked_(0)
         {
         }
 
@@ -426,9 +462,8 @@ protected:
             auto* e = this->service()->executor();
             if (!selectHelper_.is_empty() && e->is_selected(&selectHelper_)) {
                 e->unselect(&selectHelper_);
-                // will make the internal_try_write exit immediately
-                selectHelper_.remaining_ = 0;
-                // actually wake up the flow
+                // actually wake up the flow; try_write will see the fd
+                // closed.
                 this->notify();
             }
         }
@@ -444,24 +479,164 @@ protected:
             if (device()->fd() < 0) {
                 return this->release_and_exit();
             }
-            return this->write_repeated(&selectHelper_, device()->fd(),
-                this->message()->data()->data(),
-                this->message()->data()->size(), STATE(write_done),
-                this->priority());
+            add_to_batch(this->transfer_message());
+            gather();
+            if (batchSize_ < MAX_BATCH &&
+                (blocked_ || avgBatch_ >= BATCH_YIELD_THRESHOLD))
+            {
+                // Lets the producers run before writing.
+                return this->yield_and_call(STATE(gather_more));
+            }
+            return this->call_immediately(STATE(try_write));
+        }
+
+        /// Adds the buffers that arrived while we yielded. @return next state.
+        StateFlowBase::Action gather_more()
+        {
+            gather();
+            return this->call_immediately(STATE(try_write));
         }
 
-        /// State flow call. @return next state.
-        StateFlowBase::Action write_done()
+        /// Writes as much of the batch as the fd takes. @return next state.
+        StateFlowBase::Action try_write()
         {
-            if (selectHelper_.hasError_) {
-                device()->report_write_error();
+            if (device()->fd() < 0)
+            {
+                return release_batch();
             }
-            return this->release_and_exit();
+            while (iovHead_ < batchSize_ && !iov_[iovHead_].iov_len)
+            {
+                ++iovHead_;
+            }
+            if (iovHead_ >= batchSize_)
+            {
+                return release_batch();
+            }
+#ifdef OPENMRN_HAVE_WRITEV
+            ssize_t count = ::writev(
+                device()->fd(), iov_ + iovHead_, batchSize_ - iovHead_);
+#else
+            ssize_t count = ::write(device()->fd(), iov_[iovHead_].iov_base,
+                iov_[iovHead_].iov_len);
+#endif
+            if (count > 0)
+            {
+                consume(count);
+                return this->again();
+            }
+            if (count < 0 &&
+                (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            {
+                // Blocked. Waits for the fd to become writable.
+                blocked_ = 1;
+                selectHelper_.reset(
+                    Selectable::WRITE, device()->fd(), this->priority());
+                selectHelper_.set_wakeup(this);
+                this->service()->executor()->select(&selectHelper_);
+                return this->wait();
+            }
+            // Now: we are at an unknown error or EOF.
+            release_batch();
+            device()->report_write_error();
+            return this->exit();
         }
 
     private:
+        /// Largest number of buffers written in one system call.
+        static constexpr unsigned MAX_BATCH = 16;
+        /// Fixed point value of one buffer per write in avgBatch_.
+        static constexpr unsigned BATCH_ONE = 16;
+        /// If the average batch size is at least this much, we wait one
+        /// executor round before writing.
+        static constexpr unsigned BATCH_YIELD_THRESHOLD = BATCH_ONE * 3 / 2;
+
+        /// Appends a buffer to the current batch. @param b buffer to add;
+        /// ownership is transferred.
+        void add_to_batch(typename HFlow::buffer_type *b)
+        {
+            batch_[batchSize_] = b;
+            iov_[batchSize_].iov_base = (void *)b->data()->data();
+            iov_[batchSize_].iov_len = b->data()->size();
+            ++batchSize_;
+        }
+
+        /// Takes more buffers from the input queue into the batch.
+        void gather()
+        {
+            while (batchSize_ < MAX_BATCH)
+            {
+                QMember *m;
+                unsigned prio;
+                {
+                    AtomicHolder h(this);
+                    m = this->queue_next(&prio);
+                }
+                if (!m)
+                {
+                    break;
+                }
+                add_to_batch(static_cast<typename HFlow::buffer_type *>(m));
+            }
+        }
+
+        /// Advances the write position after a successful write. @param
+        /// count how many bytes were written.
+        void consume(size_t count)
+        {
+            while (count && iovHead_ < batchSize_)
+            {
+                HubIoVec &v = iov_[iovHead_];
+                if (count >= v.iov_len)
+                {
+                    count -= v.iov_len;
+                    v.iov_len = 0;
+                    ++iovHead_;
+                }
+                else
+                {
+                    v.iov_base = (char *)v.iov_base + count;
+                    v.iov_len -= count;
+                    count = 0;
+                }
+            }
+        }
+
+        /// Releases all buffers in the batch and updates the statistics.
+        /// @return next state (take next message).
+        StateFlowBase::Action release_batch()
+        {
+            // Exponential moving average with a weight of 1/4 for the newest
+            // sample.
+            avgBatch_ = (avgBatch_ * 3 + batchSize_ * BATCH_ONE) / 4;
+            if (!blocked_ && batchSize_ == 1)
+            {
+                // Fast path when the load goes away.
+                avgBatch_ = std::min(avgBatch_, (unsigned)BATCH_ONE);
+            }
+            for (unsigned i = 0; i < batchSize_; ++i)
+            {
+                batch_[i]->unref();
+            }
+            batchSize_ = 0;
+            iovHead_ = 0;
+            blocked_ = 0;
+            return this->exit();
+        }
+
         /// Helper class for asynchronous writes.
         StateFlowBase::StateFlowSelectHelper selectHelper_{this};
+        /// Buffers being written.
+        typename HFlow::buffer_type *batch_[MAX_BATCH];
+        /// Data of the buffers being written.
+        HubIoVec iov_[MAX_BATCH];
+        /// Average number of buffers per write, in BATCH_ONE units.
+        unsigned avgBatch_ : 12;
+        /// Number of entries in batch_ and iov_.
+        unsigned batchSize_ : 8;
+        /// Index of the first entry in iov_ that is not fully written.
+        unsigned iovHead_ : 8;
+        /// 1 if the current batch had to wait for the fd to be writable.
+        unsigned blocked_ : 1;
     };
 
 protected:
@@ -75,6 +75,34 @@ public:
         return size == itemSize_ ? freeCount_ : 0;
     }
 
+    /// Allocates buffers synchronously, without waiting. Takes as many
+    /// buffers as are free, up to a limit.
+    ///
+    /// @param result will be filled with the allocated buffers.
+    /// @param count is the maximum number of buffers to allocate.
+    /// @return the number of buffers put into result.
+    template <class BufferType>
+    unsigned alloc_bulk(Buffer<BufferType> **result, unsigned count)
+    {
+        HASSERT(sizeof(Buffer<BufferType>) == itemSize_);
+        {
+            AtomicHolder h(this);
+            if (count > freeCount_)
+            {
+                count = freeCount_;
+            }
+            freeCount_ -= count;
+        }
+        for (unsigned i = 0; i < count; ++i)
+        {
+            BufferBase *b = base_pool()->alloc_untyped(itemSize_, nullptr);
+            HASSERT(b);
+            b->pool_ = this;
+            alloc_async_init(b, result + i);
+        }
+        return count;
+    }
+
 protected:
     /// Internal helper funciton used by the Buffer implementation.
     BufferBase *alloc_untyped(size_t size, Executable *flow) override
@@ -68,6 +68,10 @@ protected:
     friend class Q;
     /** This class is a helper of SimpleQueue */
     friend class SimpleQueue;
+    /** DynamicPool links free items in its per-thread magazines. */
+    friend class DynamicPool;
+    /** This class is a helper of QListMpsc */
+    template <unsigned ITEMS> friend class QListMpsc;
     /** ActiveTimers needs to iterate through the queue. */
     friend class ActiveTimers;
     /** ActiveTimers needs to iterate through the queue. */
@@ -34,6 +34,7 @@
 #ifndef _UTILS_QUEUE_HXX_
 #define _UTILS_QUEUE_HXX_
 
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <cstdarg>
@@ -598,6 +599,122 @@ private:
  */
 template<unsigned items> using QListProtected = QList<items>;
 
+#if OPENMRN_FEATURE_LOCKFREE_QUEUE
+/** A list of queues that any number of threads may insert into without
+ * taking a lock, but only one thread may take items out. Index 0 is the
+ * highest priority queue.
+ *
+ * Each priority band has an inbox, which is a lock-free stack that the
+ * producers push onto with a compare-and-swap. The consumer takes the
+ * entire inbox with a single atomic exchange when it runs out of items in
+ * that band, and reverses it into a private list, so items come out in
+ * insertion order within each band.
+ */
+template <unsigned ITEMS> class QListMpsc
+{
+public:
+    /** Default Constructor.
+     */
+    QListMpsc()
+    {
+        for (unsigned i = 0; i < ITEMS; ++i)
+        {
+            inbox_[i].store(nullptr, std::memory_order_relaxed);
+            ready_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    typedef ::Result Result;
+
+    /** Add an item to the back of the queue. May be called from any thread.
+     * @param item to add to queue
+     * @param index in the list to operate on
+     */
+    void insert(QMember *item, unsigned index)
+    {
+        if (index >= ITEMS)
+        {
+            index = ITEMS - 1;
+        }
+        QMember *head = inbox_[index].load(std::memory_order_relaxed);
+        do
+        {
+            item->next = head;
+        } while (!inbox_[index].compare_exchange_weak(head, item,
+            std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /** Get an item from the front of the queue queue in priority order. Must
+     * only be called from the consumer thread.
+     * @return item retrieved from queue + index, NULL if no item available
+     */
+    Result next()
+    {
+        for (unsigned i = 0; i < ITEMS; ++i)
+        {
+            QMember *item = ready_[i].load(std::memory_order_relaxed);
+            if (!item && inbox_[i].load(std::memory_order_relaxed))
+            {
+                item = take_inbox(i);
+            }
+            if (item)
+            {
+                ready_[i].store(item->next, std::memory_order_relaxed);
+                item->next = nullptr;
+                return Result(item, i);
+            }
+        }
+        return Result();
+    }
+
+    /** Test if all the queues are empty. May be called from any thread, but
+     * the result may be stale by the time it is returned.
+     * @return true if empty (all lists), else false
+     */
+    bool empty()
+    {
+        for (unsigned i = 0; i < ITEMS; ++i)
+        {
+            if (ready_[i].load(std::memory_order_relaxed) ||
+                inbox_[i].load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    /** Moves all items from an inbox to the (empty) ready list.
+     * @param index which priority band
+     * @return the first item of the ready list.
+     */
+    QMember *take_inbox(unsigned index)
+    {
+        QMember *batch =
+            inbox_[index].exchange(nullptr, std::memory_order_acquire);
+        // The inbox has the newest item first.
+        QMember *reversed = nullptr;
+        while (batch)
+        {
+            QMember *n = batch->next;
+            batch->next = reversed;
+            reversed = batch;
+            batch = n;
+        }
+        return reversed;
+    }
+
+    /** Items inserted by the producers, newest first. */
+    std::atomic<QMember *> inbox_[ITEMS];
+    /** Items taken by the consumer, oldest first. Written only by the
+     * consumer; atomic so that empty() can be called from other threads. */
+    std::atomic<QMember *> ready_[ITEMS];
+
+    DISALLOW_COPY_AND_ASSIGN(QListMpsc);
+};
+#endif // OPENMRN_FEATURE_LOCKFREE_QUEUE
+
 
 #if 0
 /** A BufferQueue that adds the ability to wait on the next buffer.
@@ -17,6 +17,7 @@
 #include "utils/GridConnectHub.hxx"
 #include "utils/test_main.hxx"
 
+using ::testing::DoAll;
 using ::testing::AtLeast;
 using ::testing::AtMost;
 using ::testing::Eq;
@@ -85,6 +85,21 @@
  * vs the overhead used by the framework.
  */
 
+/** @var _sym_executor_use_epoll
+ *
+ * @brief On Linux, executors use an epoll instance to wait for the selected
+ * FDs. This makes adding, removing and triggering a Selectable O(1) instead of
+ * O(number of FDs), and lifts the FD_SETSIZE limit on the FD numbers. Set to
+ * false to use pselect().
+ */
+
+/** @var _sym_buffer_pool_magazine_size
+ *
+ * @brief On Linux and Mac, each thread keeps up to twice this many free
+ * buffers of every small size for itself, so that allocating and releasing
+ * buffers does not lock the shared mainBufferPool buckets every time.
+ */
+
 /** @var _sym_can_tx_buffer_size
  * @brief default software buffer size for CAN transmission
  */
@@ -131,6 +146,8 @@ DEFAULT_CONST(main_thread_priority, 0xdefa01);
 DEFAULT_CONST(main_thread_stack_size, 2048);
 DEFAULT_CONST(executor_max_sleep_msec, 40);
 DEFAULT_CONST(executor_select_prescaler, 5);
+DEFAULT_CONST_TRUE(executor_use_epoll);
+DEFAULT_CONST(buffer_pool_magazine_size, 16);
 
 DEFAULT_CONST(can_tx_buffer_size, 16);
 DEFAULT_CONST(can_rx_buffer_size, 16);
@@ -34,59 +34,123 @@
 //#define LOGLEVEL VERBOSE
 
 #include <stdint.h>
+#include <string.h>
 #include "utils/logging.h"
 #include "utils/gc_format.h"
 #include "can_frame.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 extern "C" {
 
-/** Build an ASCII character representation of a nibble value (uppercase hex).
- * @param nibble to convert
- * @return converted value
- */
-static char nibble_to_ascii(int nibble)
-{
-    nibble &= 0xf;
+/// Uppercase hex characters, indexed by the nibble value.
+static const char HEX_CHARS[17] = "0123456789ABCDEF";
 
-    if (nibble < 10)
-    {
-        return ('0' + nibble);
-    }
-    
-    return ('A' + (nibble - 10));
-}
+/// Value of a hex character (upper or lowercase), indexed by the character,
+/// or -1 if the character is not a hex digit.
+static const int8_t NIBBLE_VALUE[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
 
 /** Tries to parse a hex character to a nibble. Understands both upper and
     lowercase hex.
     @param c is the character to convert.
     @return a converted value, or -1 if an invalid character was encountered.
 */
-static int ascii_to_nibble(const char c)
+static inline int ascii_to_nibble(const char c)
 {
-    if ('0' <= c && '9' >= c)
-    {
-        return c - '0';
-    }
-    else if ('A' <= c && 'F' >= c)
-    {
-        return c - 'A' + 10;
-    }
-    else if ('a' <= c && 'f' >= c)
+    return NIBBLE_VALUE[(uint8_t)c];
+}
+
+#if defined(__SSE2__)
+/** Parses exactly 16 hex characters into 8 bytes.
+    @param buf the characters to parse.
+    @param data where to write the 8 bytes.
+    @return false if there was a non-hex character in the input.
+*/
+static bool parse_hex16(const char *buf, uint8_t *data)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)buf);
+    // Bytes >= 0x80 are negative, so they fail both range checks.
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    // Setting bit 5 turns uppercase to lowercase. Only 'A'-'F' and 'a'-'f'
+    // end up in the 'a'-'f' range after this.
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i alpha =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+            _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xFFFF)
     {
-        return c - 'a' + 10;
+        return false;
     }
-    return -1;
+    __m128i nibbles = _mm_or_si128(
+        _mm_and_si128(digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+        _mm_andnot_si128(
+            digit, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+    // Each 16-bit lane has the high nibble in the low byte and the low nibble
+    // in the high byte.
+    __m128i bytes = _mm_or_si128(
+        _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0xF0)),
+        _mm_srli_epi16(nibbles, 8));
+    _mm_storel_epi64((__m128i *)data, _mm_packus_epi16(bytes, bytes));
+    return true;
 }
 
+/** Formats 8 bytes into 16 uppercase hex characters.
+    @param data the bytes to format.
+    @param buf where to write the 16 characters.
+*/
+static void format_hex16(const uint8_t *data, char *buf)
+{
+    __m128i b = _mm_loadl_epi64((const __m128i *)data);
+    __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), mask);
+    __m128i lo = _mm_and_si128(b, mask);
+    __m128i nibbles = _mm_unpacklo_epi8(hi, lo);
+    __m128i letter = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    __m128i ascii = _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+        _mm_and_si128(letter, _mm_set1_epi8('A' - '0' - 10)));
+    _mm_storeu_si128((__m128i *)buf, ascii);
+}
+#endif
 
 int gc_format_parse(const char* buf, struct can_frame* can_frame)
 {
+    return gc_format_parse_len(buf, strcspn(buf, ";"), can_frame);
+}
+
+int gc_format_parse_len(const char *buf, size_t len, struct can_frame *can_frame)
+{
+    const char *end = buf + len;
     CLR_CAN_FRAME_ERR(*can_frame);
-    if (*buf == ':')
+    if (buf < end && *buf == ':')
     {
         // skip leading :
         ++buf;
     }
+    if (buf >= end)
+    {
+        SET_CAN_FRAME_ERR(*can_frame);
+        return -1;
+    }
     if (*buf == 'X')
     {
         SET_CAN_FRAME_EFF(*can_frame);
@@ -104,6 +168,12 @@ int gc_format_parse(const char* buf, struct can_frame* can_frame)
     uint32_t id = 0;
     while (1)
     {
+        if (buf >= end)
+        {
+            // Frame ended inside the ID.
+            SET_CAN_FRAME_ERR(*can_frame);
+            return -1;
+        }
         int nibble = ascii_to_nibble(*buf);
         if (nibble >= 0)
         {
@@ -140,12 +210,30 @@ int gc_format_parse(const char* buf, struct can_frame* can_frame)
     { 
         SET_CAN_FRAME_ID(*can_frame, id);
     }
+    size_t data_len = end - buf;
+    if ((data_len & 1) || data_len > 2 * sizeof(can_frame->data))
+    {
+        SET_CAN_FRAME_ERR(*can_frame);
+        return -1;
+    }
+#if defined(__SSE2__)
+    if (data_len == 16)
+    {
+        if (!parse_hex16(buf, can_frame->data))
+        {
+            SET_CAN_FRAME_ERR(*can_frame);
+            return -1;
+        }
+        can_frame->can_dlc = 8;
+        return 0;
+    }
+#endif
     int index = 0;
-    while ((*buf != 0) && (*buf != ';'))
+    while (buf < end)
     {
         int nh = ascii_to_nibble(*buf++);
         int nl = ascii_to_nibble(*buf++);
-        if (nh < 0 || nl < 0)
+        if ((nh | nl) < 0)
         {
             SET_CAN_FRAME_ERR(*can_frame);
             return -1;
@@ -153,32 +241,9 @@ int gc_format_parse(const char* buf, struct can_frame* can_frame)
         can_frame->data[index++] = (nh << 4) | nl;
     } // while parsing data
     can_frame->can_dlc = index;
-    CLR_CAN_FRAME_ERR(*can_frame);
     return 0;
 }
 
-/// Helper function for appending to a buffer ONCE.
-///
-/// @param dst buffer to append data to
-/// @param value one character to append to.
-///
-static void output_single(char*& dst, char value)
-{
-    *dst++ = value;
-}
-
-/// Helper function for appending to a buffer TWICE. Used in the implementation
-/// of the double-byte gridconnect output protocol.
-///
-/// @param dst buffer to append data to
-/// @param value one character to append to.
-///
-static void output_double(char*& dst, char value)
-{
-    *dst++ = value;
-    *dst++ = value;
-}
-
 /** Formats a can frame in the GridConnect protocol.
 
     If requested, it can create the double protocol with leading !!, trailing ;;
@@ -203,54 +268,88 @@ char* gc_format_generate(const struct can_frame* can_frame, char* buf, int doubl
         LOG(VERBOSE, "GC generate: incoming frame ERR.");
         return buf;
     }
-    void (*output)(char*& dst, char value);
     if (double_format)
     {
-        output = output_double;
-        output(buf, '!');
-    }
-    else
-    {
-        output = output_single;
-        output(buf, ':');
+        // Renders the single format, then doubles every character.
+        char single[32];
+        char *end = gc_format_generate(can_frame, single, 0);
+        *buf++ = '!';
+        *buf++ = '!';
+        for (const char *p = single + 1; p < end; ++p)
+        {
+            *buf++ = *p;
+            *buf++ = *p;
+        }
+        return buf;
     }
-    uint32_t id;
-    int offset;
+    *buf++ = ':';
     if (IS_CAN_FRAME_EFF(*can_frame))
     {
-        id = GET_CAN_FRAME_ID_EFF(*can_frame);
-        output(buf, 'X');
-        offset = 28;
+        uint32_t id = GET_CAN_FRAME_ID_EFF(*can_frame);
+        *buf++ = 'X';
+        for (int offset = 28; offset >= 0; offset -= 4)
+        {
+            *buf++ = HEX_CHARS[(id >> offset) & 0xf];
+        }
     }
     else
     {
-        id = GET_CAN_FRAME_ID(*can_frame);
-        output(buf, 'S');
-        offset = 8;
-    }
-    for (;offset >= 0; offset -= 4)
-    {
-        output(buf, nibble_to_ascii((id >> offset) & 0xf));
+        uint32_t id = GET_CAN_FRAME_ID(*can_frame);
+        *buf++ = 'S';
+        *buf++ = HEX_CHARS[(id >> 8) & 0xf];
+        *buf++ = HEX_CHARS[(id >> 4) & 0xf];
+        *buf++ = HEX_CHARS[id & 0xf];
     }
     /* handle remote or normal */
-    if (IS_CAN_FRAME_RTR(*can_frame))
+    *buf++ = IS_CAN_FRAME_RTR(*can_frame) ? 'R' : 'N';
+#if defined(__SSE2__)
+    if (can_frame->can_dlc == 8)
     {
-        output(buf, 'R');
+        format_hex16(can_frame->data, buf);
+        buf += 16;
     }
     else
+#endif
     {
-        output(buf, 'N');
-    }
-    for (offset = 0; offset < can_frame->can_dlc; ++offset)
-    {
-        output(buf, nibble_to_ascii(can_frame->data[offset] >> 4));
-        output(buf, nibble_to_ascii(can_frame->data[offset] & 0xf));
+        for (int offset = 0; offset < can_frame->can_dlc; ++offset)
+        {
+            uint8_t d = can_frame->data[offset];
+            *buf++ = HEX_CHARS[d >> 4];
+            *buf++ = HEX_CHARS[d & 0xf];
+        }
     }
-    output(buf, ';');
+    *buf++ = ';';
     if (config_gc_generate_newlines() == CONSTANT_TRUE) {
-        output(buf, '\n');
+        *buf++ = '\n';
     }
     return buf;
 }
 
+const char *gc_format_find_delimiter(const char *buf, const char *end)
+{
+#if defined(__SSE2__)
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i semicolon = _mm_set1_epi8(';');
+    while (end - buf >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)buf);
+        int mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, semicolon)));
+        if (mask)
+        {
+            return buf + __builtin_ctz(mask);
+        }
+        buf += 16;
+    }
+#endif
+    for (; buf < end; ++buf)
+    {
+        if (*buf == ':' || *buf == ';')
+        {
+            return buf;
+        }
+    }
+    return nullptr;
+}
+
 }
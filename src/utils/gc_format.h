@@ -34,6 +34,8 @@
 #ifndef _UTILS_GC_FORMAT_H_
 #define _UTILS_GC_FORMAT_H_
 
+#include <stddef.h>
+
 #include "utils/constants.hxx"
 
 #ifdef __cplusplus
@@ -60,6 +62,36 @@ DECLARE_CONST(gc_generate_newlines);
 */
 int gc_format_parse(const char* buf, struct can_frame* can_frame);
 
+/** Parses a GridConnect packet of known length. The packet does not need to
+    be terminated, thus this can parse the packet directly out of a received
+    data buffer.
+
+    @param buf points to the first character of the packet. A leading ':' is
+    optional.
+
+    @param len is the number of characters in the packet, excluding the
+    trailing ';'.
+
+    @param can_frame is the CAN frame that will be filled based on the source
+    packet.
+
+    @return 0 in case of success, -1 if there was a packet format error (in
+    this case the frame is set to an error frame).
+*/
+int gc_format_parse_len(
+    const char *buf, size_t len, struct can_frame *can_frame);
+
+/** Finds the next GridConnect packet delimiter (':' or ';') in a buffer.
+
+    @param buf is the first character to look at.
+
+    @param end is one past the last character to look at.
+
+    @return pointer to the first delimiter character, or NULL if there is
+    none before end.
+*/
+const char *gc_format_find_delimiter(const char *buf, const char *end);
+
 /** Formats a can frame in the GridConnect protocol.
 
     If requested, it can create the double protocol with leading !!, trailing ;;